@@ -1,7 +1,12 @@
 #include "circuit.h"
 #include <iomanip>
+#include <sstream>
 #include <utility>
 #include <cctype>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <exception>
 #include <QString>
 #include <QRegularExpression>
 namespace fs = std::filesystem;
@@ -36,6 +41,14 @@ double parseSpiceValue(const std::string& valueStr) {
             break;
         case 'm': multiplier = 1e-3;
             break;
+        case 'p': multiplier = 1e-12;
+            break;
+        case 'f': multiplier = 1e-15;
+            break;
+        case 'g': multiplier = 1e9;
+            break;
+        case 't': multiplier = 1e12;
+            break;
         default:
             found_suffix = false;
             break;
@@ -53,11 +66,57 @@ double parseSpiceValue(const std::string& valueStr) {
     return std::stod(numPart) * multiplier;
 }
 
+bool parseSourceFunction(const std::string& firstToken, std::istream& in, std::vector<double>& numericParams,
+                         std::vector<std::string>& stringParams) {
+    std::string upper = firstToken;
+    std::transform(upper.begin(), upper.end(), upper.begin(), [](unsigned char c) { return std::toupper(c); });
+
+    std::string kind;
+    if (upper.rfind("PULSE(", 0) == 0)
+        kind = "PULSE";
+    else if (upper.rfind("PWL(", 0) == 0)
+        kind = "PWL";
+    else
+        return false;
+
+    // The argument list may be spread over several tokens, up to the closing parenthesis.
+    std::string body = firstToken.substr(kind.size() + 1);
+    std::string token;
+    while (body.find(')') == std::string::npos && in >> token)
+        body += " " + token;
+    size_t close = body.find(')');
+    if (close == std::string::npos)
+        throw std::runtime_error("Missing ')' in " + kind + " source.");
+    body.erase(close);
+    std::replace(body.begin(), body.end(), ',', ' ');
+
+    numericParams.clear();
+    std::stringstream args(body);
+    while (args >> token)
+        numericParams.push_back(parseSpiceValue(token));
+
+    if (kind == "PULSE" && (numericParams.size() < 2 || numericParams.size() > 7))
+        throw std::runtime_error("Invalid PULSE source - correct form: PULSE(V1 V2 [TD TR TF PW PER])");
+    if (kind == "PWL") {
+        if (numericParams.empty() || numericParams.size() % 2 != 0)
+            throw std::runtime_error("Invalid PWL source - correct form: PWL(T1 V1 T2 V2 ...)");
+        for (size_t i = 2; i < numericParams.size(); i += 2)
+            if (numericParams[i] < numericParams[i - 2])
+                throw std::runtime_error("PWL time points must not decrease.");
+    }
+
+    stringParams = {kind};
+    return true;
+}
+
 // -------------------------------- Helper for parsing values --------------------------------
 
 
 // -------------------------------- Constructors and Destructors --------------------------------
-Circuit::Circuit() : nextNodeId(0), numCurrentUnknowns(0),
+Circuit::Circuit() : stampsCompiled(false), dcTopologyChecked(false),
+                     transientTopologyChecked(false), matrixSize(0), staticStamped(false), linearFactored(false),
+                     diagnostics(&std::cout),
+                     numCurrentUnknowns(0), transientSink(nullptr), transientPointCount(0), transientCancelled(false),
                      currentFilePath(
                          "C:\\Users\\parsa\\Documents\\university\\Programming and linux\\403101518-403101683.0\\Schematics\\draft.txt"),
                      hasNonlinearComponents(false){
@@ -71,6 +130,26 @@ Circuit::~Circuit() {
     }
 }
 
+std::unique_ptr<Circuit> Circuit::snapshot() const {
+    auto copy = std::make_unique<Circuit>();
+    copy->circuitNetList = circuitNetList;
+    copy->allFiles = allFiles;
+    copy->currentFilePath = currentFilePath;
+    copy->componentNames = componentNames;
+    copy->componentById.assign(componentById.size(), nullptr);
+    for (const Component* comp : components) {
+        copy->components.push_back(comp->clone());
+        copy->componentById[componentNames.find(comp->name)] = copy->components.back();
+    }
+    copy->nodeNames = nodeNames;
+    copy->nodeSets = nodeSets;
+    copy->groundNodeIds = groundNodeIds;
+    copy->labelToNodes = labelToNodes;
+    copy->hasNonlinearComponents = hasNonlinearComponents;
+    copy->options = options;
+    return copy;
+}
+
 // -------------------------------- Constructors and Destructors --------------------------------
 
 
@@ -80,15 +159,17 @@ void Circuit::newCircuit(const std::string& path) {
         delete comp;
     }
     components.clear();
-    nodeNameToId.clear();
-    idToNodeName.clear();
-    componentCurrentIndices.clear();
-    nextNodeId = 0;
+    componentNames.clear();
+    componentById.clear();
+    componentBranchRow.clear();
+    nodeNames.clear();
+    nodeSets = DisjointSet();
     numCurrentUnknowns = 0;
     hasNonlinearComponents = false;
     circuitNetList.clear();
     groundNodeIds.clear();
     labelToNodes.clear();
+    topologyChanged();
 
     currentFilePath = path;
 }
@@ -174,7 +255,7 @@ bool Circuit::loadCircuitFromFile() {
 
                 numericParams = {offset, amplitude, freq};
             }
-            else
+            else if (!parseSourceFunction(next_token, ss, numericParams, stringParams))
                 value = parseSpiceValue(next_token);
         }
         else if (type_char == 'D') {
@@ -215,28 +296,35 @@ bool Circuit::loadCircuitFromFile() {
 
 
 // -------------------------------- Component and Node Management --------------------------------
-void Circuit::mergeNodes(int sourceNodeId, int destNodeId) {
-    if (sourceNodeId == destNodeId)
-        return;
-
-    for (auto* comp : components) {
-        if (comp->node1 == sourceNodeId)
-            comp->node1 = destNodeId;
-        if (comp->node2 == sourceNodeId)
-            comp->node2 = destNodeId;
-    }
-
-    std::string sourceName = idToNodeName[sourceNodeId];
-    nodeNameToId[sourceName] = destNodeId;
+// Components keep the node ids they were added with; the ids joined here are resolved to one node when
+// the stamps are compiled, so a merge costs a near-constant union instead of a pass over the circuit.
+void Circuit::mergeNodes(int nodeA, int nodeB) {
+    if (nodeSets.unite(nodeA, nodeB))
+        topologyChanged();
+}
 
-    for (auto& pair : labelToNodes) {
-        if (pair.second.count(sourceNodeId)) {
-            pair.second.erase(sourceNodeId);
-            pair.second.insert(destNodeId);
-        }
+// Every set of merged ids is represented by its smallest id, so a merged node goes by the name of the
+// first of its ids. Returns the representative of each node id.
+std::vector<int> Circuit::resolveNodes() const {
+    std::vector<int> representative(nodeNames.size());
+    std::vector<int> smallest(nodeNames.size(), -1);
+    for (int i = 0; i < nodeNames.size(); ++i) {
+        int root = nodeSets.find(i);
+        if (smallest[root] == -1)
+            smallest[root] = i;
+        representative[i] = smallest[root];
     }
+    return representative;
+}
 
-    idToNodeName.erase(sourceNodeId);
+// Anything cached per topology (symbolic factorization, ...) is dropped here.
+void Circuit::topologyChanged() {
+    mnaSolver.invalidate();
+    staticStamped = false;
+    stampsCompiled = false;
+    dcTopologyChecked = false;
+    transientTopologyChecked = false;
+    linearFactored = false;
 }
 
 void Circuit::clearSchematic() {
@@ -244,53 +332,45 @@ void Circuit::clearSchematic() {
 }
 
 int Circuit::getNodeId(const std::string& nodeName, bool create) {
-    if (nodeNameToId.find(nodeName) == nodeNameToId.end()) {
-        if (create) {
-            nodeNameToId[nodeName] = nextNodeId;
-            idToNodeName[nextNodeId] = nodeName;
-            return nextNodeId++;
-        }
-        return -1;
+    int nodeId = nodeNames.find(nodeName);
+    if (nodeId == -1 && create) {
+        nodeId = nodeNames.intern(nodeName);
+        nodeSets.grow(nodeNames.size());
     }
-    return nodeNameToId[nodeName];
+    return nodeId;
 }
 
 int Circuit::getNodeId(const std::string& nodeName) const {
-    auto it =  nodeNameToId.find(nodeName);
-    if (it != nodeNameToId.end())
-        return it->second;
-    return -1;
+    return nodeNames.find(nodeName);
 }
 
 bool Circuit::hasNode(const std::string& nodeName) const {
-    return nodeNameToId.count(nodeName);
+    return nodeNames.find(nodeName) != -1;
 }
 
 void Circuit::addComponent(const std::string& typeStr, const std::string& name,
                            const std::string& node1Str, const std::string& node2Str,
                            double value, const std::vector<double>& numericParams,
                            const std::vector<std::string>& stringParams, bool isSinusoidal) {
-    for (const auto& comp : components) {
-        if (comp->name == name) {
-            std::string errorMsg;
-            if (comp->type == Component::Type::RESISTOR)
-                errorMsg = "Resistor ";
-            else if (comp->type == Component::Type::CAPACITOR)
-                errorMsg = "Capacitor ";
-            else if (comp->type == Component::Type::INDUCTOR)
-                errorMsg = "Inductor ";
-            else if (comp->type == Component::Type::DIODE)
-                errorMsg = "Diode ";
-            else if (comp->type == Component::Type::VOLTAGE_SOURCE)
-                errorMsg = "Voltage source ";
-            else if (comp->type == Component::Type::CURRENT_SOURCE)
-                errorMsg = "Current source ";
-            else
-                errorMsg = "Component ";
+    if (const Component* comp = getComponent(name)) {
+        std::string errorMsg;
+        if (comp->type == Component::Type::RESISTOR)
+            errorMsg = "Resistor ";
+        else if (comp->type == Component::Type::CAPACITOR)
+            errorMsg = "Capacitor ";
+        else if (comp->type == Component::Type::INDUCTOR)
+            errorMsg = "Inductor ";
+        else if (comp->type == Component::Type::DIODE)
+            errorMsg = "Diode ";
+        else if (comp->type == Component::Type::VOLTAGE_SOURCE)
+            errorMsg = "Voltage source ";
+        else if (comp->type == Component::Type::CURRENT_SOURCE)
+            errorMsg = "Current source ";
+        else
+            errorMsg = "Component ";
 
-            errorMsg += comp->name + " already exists in the circuit.";
-            throw std::runtime_error(errorMsg);
-        }
+        errorMsg += comp->name + " already exists in the circuit.";
+        throw std::runtime_error(errorMsg);
     }
 
     int n1_id = getNodeId(node1Str);
@@ -301,8 +381,13 @@ void Circuit::addComponent(const std::string& typeStr, const std::string& name,
                                                                stringParams, isSinusoidal, this);
         if (newComp) {
             components.push_back(newComp);
+            int componentId = componentNames.intern(name);
+            if (componentId >= static_cast<int>(componentById.size()))
+                componentById.resize(componentId + 1, nullptr);
+            componentById[componentId] = newComp;
             if (newComp->isNonlinear())
                 hasNonlinearComponents = true;
+            topologyChanged();
             std::cout << "Added " << name << "." << std::endl;
         }
     }
@@ -312,40 +397,42 @@ void Circuit::addComponent(const std::string& typeStr, const std::string& name,
 }
 
 Component* Circuit::getComponent(const std::string& name) const {
-    for (Component* comp : components) {
-        if (comp->name == name) {
-            return comp;
-        }
-    }
-    return nullptr;
+    int componentId = componentNames.find(name);
+    return componentId == -1 ? nullptr : componentById[componentId];
 }
 
 bool Circuit::isGround(int nodeId) const {
-    return groundNodeIds.count(nodeId);
+    int node = nodeSets.find(nodeId);
+    for (int ground : groundNodeIds) {
+        if (nodeSets.find(ground) == node)
+            return true;
+    }
+    return false;
 }
 
 void Circuit::addGround(const std::string& nodeName) {
     int nodeId = getNodeId(nodeName, true);
     if (!isGround(nodeId)) {
         groundNodeIds.insert(nodeId);
+        topologyChanged();
         std::cout << "Ground added." << std::endl;
     }
 }
 
 void Circuit::deleteComponent(const std::string& componentName, char typeChar) {
-    for (auto it = components.begin(); it != components.end(); it++) {
-        if ((*it)->getName() == componentName) {
-            delete *it;
-            components.erase(it);
-            for (auto it = circuitNetList.begin(); it != circuitNetList.end(); it++) {
-                if (it->find(componentName) != std::string::npos) {
-                    circuitNetList.erase(it);
-                    break;
-                }
+    if (Component* comp = getComponent(componentName)) {
+        componentById[componentNames.find(componentName)] = nullptr;
+        components.erase(std::find(components.begin(), components.end(), comp));
+        delete comp;
+        topologyChanged();
+        for (auto it = circuitNetList.begin(); it != circuitNetList.end(); it++) {
+            if (it->find(componentName) != std::string::npos) {
+                circuitNetList.erase(it);
+                break;
             }
-            std::cout << "Component " << componentName << " deleted." << std::endl;
-            return;
         }
+        std::cout << "Component " << componentName << " deleted." << std::endl;
+        return;
     }
 
     if (typeChar == 'R')
@@ -365,22 +452,28 @@ void Circuit::deleteComponent(const std::string& componentName, char typeChar) {
 void Circuit::deleteGround(const std::string& ground_node_name) {
     if (!hasNode(ground_node_name))
         std::cout << "Node does not exist." << std::endl;
-    else if (!isGround(nodeNameToId[ground_node_name]))
+    else if (!isGround(nodeNames.find(ground_node_name)))
         std::cout << "This node isn't ground!" << std::endl;
     else {
-        groundNodeIds.erase(nodeNameToId[ground_node_name]);
+        int node = nodeSets.find(nodeNames.find(ground_node_name));
+        std::erase_if(groundNodeIds, [&](int ground) { return nodeSets.find(ground) == node; });
+        topologyChanged();
         std::cout << "Ground deleted." << std::endl;
     }
 }
 
+// Merged ids are one node, listed once under its representative's name.
 void Circuit::listNodes() const {
     std::cout << "Available nodes:" << std::endl;
-    for (int i = 0; i < idToNodeName.size(); i++) {
-        if (i == idToNodeName.size() - 1) {
-            std::cout << idToNodeName.at(i);
-            break;
-        }
-        std::cout << idToNodeName.at(i) << ", ";
+    std::vector<int> representative = resolveNodes();
+    bool first = true;
+    for (int i = 0; i < nodeNames.size(); i++) {
+        if (representative[i] != i)
+            continue;
+        if (!first)
+            std::cout << ", ";
+        std::cout << nodeNames.name(i);
+        first = false;
     }
     std::cout << std::endl;
 }
@@ -388,30 +481,29 @@ void Circuit::listNodes() const {
 void Circuit::listComponents(char typeFilter) const {
     if (!typeFilter)
         for (Component* component : components)
-            std::cout << component->name << " " << idToNodeName.at(component->node1) << " " << idToNodeName.
-                at(component->node2) << " " << component->value << std::endl;
+            std::cout << component->name << " " << nodeNames.name(component->node1) << " " << nodeNames.
+                name(component->node2) << " " << component->value << std::endl;
 
     else
         for (Component* component : components)
             if (component->name[0] == typeFilter)
-                std::cout << component->name << " " << idToNodeName.at(component->node1) << " " << idToNodeName.
-                    at(component->node2) << " " << component->value << std::endl;
+                std::cout << component->name << " " << nodeNames.name(component->node1) << " " << nodeNames.
+                    name(component->node2) << " " << component->value << std::endl;
 }
 
 void Circuit::renameNode(const std::string& oldName, const std::string& newName) {
-    if (nodeNameToId.find(oldName) == nodeNameToId.end()) {
+    int nodeId = nodeNames.find(oldName);
+    if (nodeId == -1) {
         std::cout << "ERROR: Node " << oldName << " does not exist." << std::endl;
         return;
     }
-    if (nodeNameToId.count(newName)) {
+    if (nodeNames.find(newName) != -1) {
         std::cout << "ERROR: Node " << newName << " already exists." << std::endl;
         return;
     }
 
-    int nodeId = nodeNameToId[oldName];
-    nodeNameToId.erase(oldName);
-    nodeNameToId[newName] = nodeId;
-    idToNodeName[nodeId] = newName;
+    nodeNames.rename(nodeId, newName);
+    topologyChanged();
 
     std::cout << "SUCCESS: Node renamed from " << oldName << " to " << newName << std::endl;
 
@@ -428,12 +520,7 @@ void Circuit::connectNodes(const std::string& nodeAStr, const std::string& nodeB
     int nodeAInt = getNodeId(nodeAStr, true);
     int nodeBInt = getNodeId(nodeBStr, true);
 
-    int sourceNodeId = std::max(nodeAInt, nodeBInt);
-    int destNodeId = std::min(nodeAInt, nodeBInt);
-
-    if (sourceNodeId != destNodeId) {
-        mergeNodes(sourceNodeId, destNodeId);
-    }
+    mergeNodes(nodeAInt, nodeBInt);
 
     std::cout << "Node '" << nodeAStr << "' successfully connected to '" << nodeBStr << "'." << std::endl;
 }
@@ -449,73 +536,310 @@ void Circuit::addLabel(const std::string& labelName, const std::string& nodeName
 
 
 // -------------------------------- MNA and Solver --------------------------------
-void Circuit::buildMNAMatrix(double time, double h) {
-    std::map<int, int> nodeIdToMnaIndex;
-    int currentMnaIndex = 0;
-    for (int i = 0; i < nextNodeId; ++i) {
-        if (!isGround(i) && idToNodeName.count(i)) {
-            nodeIdToMnaIndex[i] = currentMnaIndex++;
-        }
+// Floating nodes and voltage source loops make the matrix singular whatever the values, so they are
+// looked for on the graph once per topology and reported by name before anything is factorized.
+void Circuit::checkTopology(TopologyAnalysis analysis) {
+    bool& checked = analysis == TopologyAnalysis::DC ? dcTopologyChecked : transientTopologyChecked;
+    if (checked)
+        return;
+
+    if (!stampsCompiled)
+        compileStamps();
+    std::vector<std::string> problems = findTopologyProblems(components, nodeNames, nodeRepresentative,
+                                                             groundNodeIds, analysis);
+    if (!problems.empty()) {
+        std::string message = "The circuit cannot be solved:";
+        for (const std::string& problem : problems)
+            message += "\n  " + problem;
+        throw std::runtime_error(message);
     }
+    checked = true;
+}
 
-    int node_count = nodeIdToMnaIndex.size();
+// Builds the compiled view of the topology: the node every id was merged into, the MNA row of every node
+// id (merged ids share the row of their node, rows follow the representatives in ascending order) and the
+// branch rows. Components get their rows resolved as well, so stamping needs no lookups.
+void Circuit::compileStamps() {
+    nodeRepresentative = resolveNodes();
+    int nodeIdCount = nodeNames.size();
+    std::vector<bool> groundNode(nodeIdCount, false);
+    for (int ground : groundNodeIds)
+        groundNode[nodeRepresentative[ground]] = true;
+
+    nodeMnaRow.assign(nodeIdCount, -1);
+    int node_count = 0;
+    for (int i = 0; i < nodeIdCount; ++i) {
+        int node = nodeRepresentative[i];
+        if (groundNode[node])
+            continue;
+        nodeMnaRow[i] = node == i ? node_count++ : nodeMnaRow[node];
+    }
 
     numCurrentUnknowns = 0;
-    componentCurrentIndices.clear();
+    componentBranchRow.assign(componentNames.size(), -1);
     for (Component* comp : components) {
         if (comp->needsCurrentUnknown()) {
-            componentCurrentIndices[comp->name] = node_count + numCurrentUnknowns;
+            componentBranchRow[componentNames.find(comp->name)] = node_count + numCurrentUnknowns;
             numCurrentUnknowns++;
         }
     }
 
-    int matrix_size = node_count + numCurrentUnknowns;
+    for (Component* comp : components)
+        comp->compileStamps(nodeMnaRow, componentNames, componentBranchRow,
+                            componentBranchRow[componentNames.find(comp->name)]);
+
+    matrixSize = node_count + numCurrentUnknowns;
+    stampsCompiled = true;
+}
+
+// MNA row of a node id in the last compiled view, -1 for ground and for nodes added since. The stored
+// results follow that view, so the result queries read them through it even after an edit.
+int Circuit::nodeRow(int nodeId) const {
+    if (nodeId < 0 || nodeId >= static_cast<int>(nodeMnaRow.size()))
+        return -1;
+    return nodeMnaRow[nodeId];
+}
+
+// MNA row of a component's current in the last compiled view, -1 when it has none
+int Circuit::branchRow(const std::string& componentName) const {
+    int componentId = componentNames.find(componentName);
+    if (componentId == -1 || componentId >= static_cast<int>(componentBranchRow.size()))
+        return -1;
+    return componentBranchRow[componentId];
+}
+
+void Circuit::buildMNAMatrix(const StepContext& step, Restamp restamp) {
+    if (!stampsCompiled)
+        compileStamps();
+    int matrix_size = matrixSize;
+
+    if (restamp == Restamp::RHS_ONLY) {
+        b_mna.setZero();
+        A_mna.setFrozen(true);
+        for (size_t i = 0; i < components.size(); ++i) {
+            components[i]->stampTimeStep(A_mna, b_mna, step);
+            components[i]->stampIteration(A_mna, b_mna, step);
+        }
+        A_mna.setFrozen(false);
+        return;
+    }
+
+    if (A_mna.getBackend() != options.solver) {
+        A_mna.setBackend(options.solver);
+        staticStamped = false;
+    }
     if (matrix_size <= 0) {
-        A_mna.resize(0, 0);
+        A_mna.resize(0);
         b_mna.resize(0);
         return;
     }
-    if (A_mna.rows() != matrix_size) {
-        A_mna.resize(matrix_size, matrix_size);
+    if (b_mna.size() != matrix_size)
         b_mna.resize(matrix_size);
+
+    // The static layer only changes with the topology.
+    if (!staticStamped || A_mna.size() != matrix_size) {
+        A_mna.resize(matrix_size);
+        for (size_t i = 0; i < components.size(); ++i)
+            components[i]->stampStatic(A_mna);
+        A_mna.saveLayer(MNAMatrix::Layer::STATIC);
+        staticStamped = true;
+        restamp = Restamp::TIME_POINT;
     }
-    A_mna.setZero();
-    b_mna.setZero();
 
-    for (Component* comp : components) {
-        int idx = -1;
-        if (comp->needsCurrentUnknown()) {
-            idx = componentCurrentIndices.at(comp->name);
-        }
-        comp->stampMNA(A_mna, b_mna, componentCurrentIndices, nodeIdToMnaIndex, time, h, idx);
+    if (restamp == Restamp::TIME_POINT) {
+        A_mna.restoreLayer(MNAMatrix::Layer::STATIC);
+        b_mna.setZero();
+        for (size_t i = 0; i < components.size(); ++i)
+            components[i]->stampTimeStep(A_mna, b_mna, step);
+        A_mna.saveLayer(MNAMatrix::Layer::TIME_STEP);
+        b_timeStep = b_mna;
+    }
+    else {
+        A_mna.restoreLayer(MNAMatrix::Layer::TIME_STEP);
+        b_mna = b_timeStep;
+    }
+
+    StepContext iterationStep = step;
+    if (options.bypass) {
+        iterationStep.bypassReltol = options.reltol;
+        iterationStep.bypassVntol = options.vntol;
+        iterationStep.bypassAbstol = options.abstol;
     }
+    for (size_t i = 0; i < components.size(); ++i)
+        components[i]->stampIteration(A_mna, b_mna, iterationStep);
+    A_mna.finalize();
 }
 
 
 Eigen::VectorXd Circuit::solveMNASystem() {
-    if (A_mna.rows() == 0) {
-        std::cout << "MNA matrix is empty. Cannot solve." << std::endl;
+    if (A_mna.size() == 0) {
+        *diagnostics << "MNA matrix is empty. Cannot solve." << std::endl;
         return Eigen::VectorXd();
     }
 
-    Eigen::FullPivLU<Eigen::MatrixXd> lu(A_mna);
-    if (!lu.isInvertible()) {
-        std::cout << "ERROR: Circuit matrix is singular. Check for floating nodes or invalid connections." << std::endl;
+    linearFactored = false;
+    if (!mnaSolver.factorize(A_mna)) {
+        *diagnostics << "ERROR: Circuit matrix is singular." << std::endl;
         return Eigen::VectorXd(); // Return empty vector
     }
-    return lu.solve(b_mna);
+    return mnaSolver.solve(b_mna);
 }
 
-void Circuit::updateComponentStates(const Eigen::VectorXd& solution, const std::map<int, int>& nodeIdToMnaIndex) {
+// For a linear circuit with a fixed step only the RHS changes between time points (sources and the
+// capacitor/inductor history terms), so A is factorized on the first step and reused afterwards.
+// The transient matrix only depends on the method and the step sizes, not on the time point itself.
+static bool sameStepMatrix(const StepContext& a, const StepContext& b) {
+    return a.method == b.method && a.h == b.h &&
+           (a.method != IntegrationMethod::GEAR2 || a.hPrev == b.hPrev);
+}
+
+Eigen::VectorXd Circuit::solveLinearTimeStep(const StepContext& step) {
+    if (!linearFactored || !sameStepMatrix(factoredStep, step) || A_mna.size() == 0) {
+        buildMNAMatrix(step);
+        Eigen::VectorXd solution = solveMNASystem();
+        if (solution.size() > 0) {
+            linearFactored = true;
+            factoredStep = step;
+        }
+        return solution;
+    }
+
+    buildMNAMatrix(step, Restamp::RHS_ONLY);
+    return mnaSolver.solve(b_mna);
+}
+
+StepContext Circuit::transientStep(double time, double h, double hPrev) const {
+    StepContext step;
+    step.time = time;
+    step.h = h;
+    step.hPrev = hPrev;
+    step.method = options.method;
+    return step;
+}
+
+// Solves one transient time point, with Newton iterations when the circuit has nonlinear components.
+Eigen::VectorXd Circuit::solveTimePoint(const StepContext& step, bool& converged) {
+    if (!hasNonlinearComponents) {
+        converged = true;
+        return solveLinearTimeStep(step);
+    }
+
+    const int MAX_ITERATIONS = 100;
+    converged = false;
+    Eigen::VectorXd solution, lastSolution;
+    int factorAge = 0;
+
+    for (int i = 0; i < MAX_ITERATIONS; ++i) {
+        buildMNAMatrix(step, i == 0 ? Restamp::TIME_POINT : Restamp::NEWTON_ITERATION);
+        solution = solveNewtonIteration(lastSolution, factorAge);
+        if (solution.size() == 0) break;
+
+        if (newtonConverged(solution, lastSolution)) {
+            converged = true;
+            break;
+        }
+        lastSolution = solution;
+        updateNonlinearComponentStates(solution);
+    }
+    return solution;
+}
+
+// One Newton solve of the freshly built system. factorAge counts the iterations served by the current LU
+// factorization and starts at 0 in every Newton loop. A factorization is kept
+//   - for up to LUREUSE iterations (modified Newton), as long as every nonlinear device is still within
+//     10% of the tangent it was factorized with; a device far from it would make the old matrix useless,
+//   - and for any number of iterations when every nonlinear device was bypassed, since A has not changed.
+// A kept factorization solves for the correction from the last iterate's residual, so the iteration still
+// converges to the solution of the present A and b.
+Eigen::VectorXd Circuit::solveNewtonIteration(const Eigen::VectorXd& lastSolution, int& factorAge) {
+    const double LINEARITY_TOLERANCE = 0.1;
+
+    bool reuse = factorAge > 0 && lastSolution.size() == A_mna.size();
+    for (const Component* comp : components) {
+        if (!reuse)
+            break;
+        if (!comp->isNonlinear())
+            continue;
+        if (factorAge < options.luReuse)
+            reuse = comp->currentConverged(lastSolution, LINEARITY_TOLERANCE, options.abstol);
+        else
+            reuse = comp->bypassed();
+    }
+
+    if (reuse) {
+        factorAge++;
+        return lastSolution + mnaSolver.solve(b_mna - A_mna.multiply(lastSolution));
+    }
+    factorAge = 1;
+    return solveMNASystem();
+}
+
+// SPICE-style Newton convergence: every unknown has moved by at most RELTOL of its magnitude plus VNTOL
+// (node voltages) or ABSTOL (branch currents) since the last iteration, and every nonlinear device's
+// linearized current agrees with its real current. False when there is no last iteration to compare to.
+bool Circuit::newtonConverged(const Eigen::VectorXd& solution, const Eigen::VectorXd& lastSolution) const {
+    if (lastSolution.size() != solution.size())
+        return false;
+
+    const Eigen::Index nodeUnknowns = solution.size() - numCurrentUnknowns;
+    for (Eigen::Index i = 0; i < solution.size(); ++i) {
+        double tolerance = options.reltol * std::max(std::abs(solution(i)), std::abs(lastSolution(i))) +
+                           (i < nodeUnknowns ? options.vntol : options.abstol);
+        if (!(std::abs(solution(i) - lastSolution(i)) <= tolerance))
+            return false;
+    }
+    for (const Component* comp : components)
+        if (comp->isNonlinear() && !comp->currentConverged(solution, options.reltol, options.abstol))
+            return false;
+    return true;
+}
+
+// The local truncation error of an order p method is C * h^(p+1) * x^(p+1), with C = 1/2 for backward
+// Euler, 1/12 for trapezoidal and 2/9 for Gear-2. The derivative comes from the divided difference of the
+// last p + 2 points, times holds them oldest first with the new point last. An order 1 estimate uses the
+// backward Euler constant whatever the method, which errs on the safe side for the second order ones.
+// Returns the largest LTE / tolerance ratio over all unknowns, so <= 1 means the step is good.
+double Circuit::truncationErrorRatio(const std::vector<double>& times, const std::vector<Eigen::VectorXd>& points,
+                                     int order) const {
+    const double errorConstant = order == 1 ? 1.0 / 2.0
+                               : options.method == IntegrationMethod::TRAPEZOIDAL ? 1.0 / 12.0 : 2.0 / 9.0;
+    const int last = order + 1;
+    const double h = times[last] - times[last - 1];
+    double factorial = 1.0;
+    for (int k = 2; k <= last; ++k)
+        factorial *= k;
+    const double scale = errorConstant * std::pow(h, last) * factorial;
+
+    const Eigen::VectorXd& x = points[last];
+    const Eigen::VectorXd& x1 = points[last - 1];
+    int nodeCount = matrixSize - numCurrentUnknowns;
+    double worst = 0.0;
+    double dd[4];
+    for (int i = 0; i < x.size(); ++i) {
+        for (int j = 0; j <= last; ++j)
+            dd[j] = points[j](i);
+        for (int level = 1; level <= last; ++level)
+            for (int j = 0; j + level <= last; ++j)
+                dd[j] = (dd[j + 1] - dd[j]) / (times[j + level] - times[j]);
+
+        double lte = scale * std::abs(dd[0]);
+        double absTol = i < nodeCount ? options.vntol : options.abstol;
+        double tol = options.trtol * (options.reltol * std::max(std::abs(x(i)), std::abs(x1(i))) + absTol);
+        worst = std::max(worst, lte / tol);
+    }
+    return worst;
+}
+
+void Circuit::updateComponentStates(const Eigen::VectorXd& solution) {
     for (Component* comp : components) {
-        comp->updateState(solution, componentCurrentIndices, nodeIdToMnaIndex);
+        comp->updateState(solution);
     }
 }
 
-void Circuit::updateNonlinearComponentStates(const Eigen::VectorXd& solution, const std::map<int, int>& nodeIdToMnaIndex) {
+void Circuit::updateNonlinearComponentStates(const Eigen::VectorXd& solution) {
     for (Component* comp : components) {
         if (comp->isNonlinear()) {
-            comp->updateState(solution, componentCurrentIndices, nodeIdToMnaIndex);
+            comp->updateState(solution);
         }
     }
 }
@@ -530,77 +854,284 @@ void Circuit::performDCAnalysis(const std::string& sourceName, double startValue
         throw std::runtime_error("Source '" + sourceName + "' for DC sweep not found.");
     if (groundNodeIds.empty())
         throw std::runtime_error("No ground node detected.");
+    if (!dynamic_cast<VoltageSource*>(sweepSource) && !dynamic_cast<CurrentSource*>(sweepSource))
+        throw std::runtime_error("Component '" + sourceName + "' is not a sweepable source.");
+    checkTopology(TopologyAnalysis::DC);
 
     std::cout << "\n--- Performing DC Sweep Analysis on " << sourceName << " ---" << std::endl;
     std::cout << "Start: " << startValue << ", Stop: " << endValue << ", Increment: " << increment << std::endl;
 
     dcSweepSolutions.clear();
+    dcSweepSource = sourceName;
+
+    // The sweep still runs, with the source at its waveform's value at t = 0
+    if (!setSourceValue(sweepSource, startValue))
+        std::cout << "Cannot perform DC Sweep on non-dc source: " << sourceName << std::endl;
+
+    std::vector<double> sweepValues;
+    for (double sweepValue = startValue; sweepValue <= endValue; sweepValue += increment)
+        sweepValues.push_back(sweepValue);
+    std::vector<Eigen::VectorXd> solutions(sweepValues.size());
+
+    // A nonlinear point continues from the solution of the previous one, so the sweep is cut into
+    // segments of a fixed length rather than one chunk per thread: the segment starts are solved first,
+    // in a serial sweep of their own, and every segment then continues from its start. The history a
+    // point is reached from, and with it the branch it converges to, does not depend on the thread count.
+    // Linear points need no history and skip the serial pass. Each thread sweeps whole segments on its
+    // own snapshot of the circuit, since the components and the MNA system carry per-point state.
+    const size_t SEGMENT_POINTS = 64;
+    size_t segmentCount = (sweepValues.size() + SEGMENT_POINTS - 1) / SEGMENT_POINTS;
+    std::vector<char> convergedPoints(sweepValues.size(), 0);
+    size_t newtonIterations = 0;
+    if (hasNonlinearComponents) {
+        std::vector<double> startValues;
+        for (size_t s = 0; s < segmentCount; ++s)
+            startValues.push_back(sweepValues[s * SEGMENT_POINTS]);
+        std::vector<Eigen::VectorXd> startSolutions(segmentCount);
+        std::vector<char> startConverged(segmentCount, 0);
+        newtonIterations = sweepDcPoints(sourceName, startValues, 0, segmentCount, startSolutions, startConverged);
+        for (size_t s = 0; s < segmentCount; ++s) {
+            solutions[s * SEGMENT_POINTS] = std::move(startSolutions[s]);
+            convergedPoints[s * SEGMENT_POINTS] = startConverged[s];
+        }
+    }
+
+    // Sweeps segments [first, last) on circuit, leaving out their already solved starts. A linear range
+    // is swept in one go, so it is factorized once.
+    auto sweepSegments = [&](Circuit* circuit, size_t first, size_t last) {
+        size_t end = std::min(last * SEGMENT_POINTS, sweepValues.size());
+        if (!hasNonlinearComponents)
+            return circuit->sweepDcPoints(sourceName, sweepValues, first * SEGMENT_POINTS, end, solutions,
+                                          convergedPoints);
+        size_t iterations = 0;
+        for (size_t s = first; s < last; ++s)
+            iterations += circuit->sweepDcPoints(sourceName, sweepValues, s * SEGMENT_POINTS + 1,
+                                                 std::min((s + 1) * SEGMENT_POINTS, end), solutions,
+                                                 convergedPoints);
+        return iterations;
+    };
+
+    size_t threadCount = options.threads > 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    threadCount = std::min(threadCount, std::max<size_t>(1, segmentCount));
+
+    if (threadCount <= 1)
+        newtonIterations += sweepSegments(this, 0, segmentCount);
+    else {
+        std::vector<std::unique_ptr<Circuit>> workers;
+        std::vector<std::thread> threads;
+        std::vector<std::exception_ptr> errors(threadCount);
+        std::vector<size_t> iterations(threadCount, 0);
+        // Each worker collects its messages, printed in sweep order once all have finished
+        std::vector<std::ostringstream> logs(threadCount);
+        for (size_t w = 0; w < threadCount; ++w) {
+            size_t first = segmentCount * w / threadCount;
+            size_t last = segmentCount * (w + 1) / threadCount;
+            workers.push_back(snapshot());
+            Circuit* worker = workers.back().get();
+            worker->diagnostics = &logs[w];
+            threads.emplace_back([&, worker, w, first, last]() {
+                try {
+                    iterations[w] = sweepSegments(worker, first, last);
+                } catch (...) {
+                    errors[w] = std::current_exception();
+                }
+            });
+        }
+        for (std::thread& thread : threads)
+            thread.join();
+        for (const std::ostringstream& log : logs)
+            *diagnostics << log.str();
+        for (const std::exception_ptr& error : errors)
+            if (error)
+                std::rethrow_exception(error);
+        for (size_t count : iterations)
+            newtonIterations += count;
+
+        // The workers compiled their own copies; this circuit needs the same indices to print the results.
+        compileStamps();
+        if (!sweepValues.empty())
+            setSourceValue(sweepSource, sweepValues.back());
+    }
+
+    for (size_t k = 0; k < sweepValues.size(); ++k)
+        dcSweepSolutions.emplace_hint(dcSweepSolutions.end(), sweepValues[k], std::move(solutions[k]));
+    std::cout << "DC Sweep complete. " << dcSweepSolutions.size() << " points calculated";
+    if (threadCount > 1)
+        std::cout << " on " << threadCount << " threads";
+    std::cout << "." << std::endl;
+    if (hasNonlinearComponents && !sweepValues.empty()) {
+        // Formatted on its own, std::cout may still be in the fixed notation of an earlier .print
+        std::ostringstream average;
+        average << std::setprecision(3) << static_cast<double>(newtonIterations) / sweepValues.size();
+        std::cout << "Newton iterations per point: " << average.str() << std::endl;
+    }
+}
+
+// False when the source is not a DC source, which keeps its waveform
+bool Circuit::setSourceValue(Component* source, double value) {
+    if (auto vs = dynamic_cast<VoltageSource*>(source))
+        return vs->setValue(value);
+    if (auto cs = dynamic_cast<CurrentSource*>(source))
+        return cs->setValue(value);
+    return false;
+}
+
+// Solves sweep points [begin, end) into solutions[begin, end) and marks the converged ones in
+// convergedPoints[begin, end), leaving the other entries alone. Returns the number of Newton iterations spent.
+//
+// Nonlinear points are solved by continuation from the previous sweep point (see continueDcSolution);
+// the first one continues from point begin - 1 if that has converged. A point without a converged
+// predecessor, or one the continuation cannot reach, starts over from reset devices, and failing that
+// is reached by source stepping up from 0.
+size_t Circuit::sweepDcPoints(const std::string& sourceName, const std::vector<double>& sweepValues, size_t begin,
+                              size_t end, std::vector<Eigen::VectorXd>& solutions, std::vector<char>& convergedPoints) {
+    Component* sweepSource = getComponent(sourceName);
     for (Component* component : components)
         component->reset();
 
-    std::map<int, int> nodeIdToMnaIndex;
-
-    for (double sweepValue = startValue; sweepValue <= endValue; sweepValue += increment) {
-        if (auto vs = dynamic_cast<VoltageSource*>(sweepSource))
-            vs->setValue(sweepValue);
-        else if (auto cs = dynamic_cast<CurrentSource*>(sweepSource))
-            cs->setValue(sweepValue);
-        else
-            throw std::runtime_error("Component '" + sourceName + "' is not a sweepable source.");
+    size_t totalIterations = 0;
+    // The last two converged sweep points, newest first
+    double value1 = 0.0, value2 = 0.0;
+    Eigen::VectorXd solution1, solution2;
+    if (begin > 0 && begin < end && convergedPoints[begin - 1]) {
+        value1 = sweepValues[begin - 1];
+        solution1 = solutions[begin - 1];
+    }
 
+    for (size_t k = begin; k < end; ++k) {
+        double sweepValue = sweepValues[k];
         Eigen::VectorXd solution;
-        buildMNAMatrix(0.0, 0.0);
-        nodeIdToMnaIndex.clear();
-        int currentMnaIndex = 0;
-        for (int i = 0; i < nextNodeId; ++i) {
-            if (idToNodeName.count(i) && !isGround(i)) {
-                nodeIdToMnaIndex[i] = currentMnaIndex++;
+
+        // Only b follows the swept source, so A is factorized once for the range
+        if (!hasNonlinearComponents) {
+            setSourceValue(sweepSource, sweepValue);
+            if (k == begin || !convergedPoints[k - 1]) {
+                buildMNAMatrix(StepContext());
+                solutions[k] = solveMNASystem();
+            }
+            else {
+                buildMNAMatrix(StepContext(), Restamp::RHS_ONLY);
+                solutions[k] = mnaSolver.solve(b_mna);
             }
+            convergedPoints[k] = solutions[k].size() > 0;
+            continue;
         }
 
-        if (!hasNonlinearComponents) {
-            solution = solveMNASystem();
+        bool converged = false;
+        int iterations = 0;
+        if (solution1.size() > 0)
+            converged = continueDcSolution(sweepSource, value1, solution1, value2, solution2, sweepValue, solution,
+                                           totalIterations);
+
+        if (!converged) {
+            setSourceValue(sweepSource, sweepValue);
+            converged = solveDcNewton(nullptr, solution, iterations);
+            totalIterations += iterations;
+        }
+        // Source stepping: solve with the swept source at 0 and walk up to the sweep value from there
+        if (!converged && sweepValue != 0.0) {
+            Eigen::VectorXd zeroSolution;
+            setSourceValue(sweepSource, 0.0);
+            if (solveDcNewton(nullptr, zeroSolution, iterations))
+                converged = continueDcSolution(sweepSource, 0.0, zeroSolution, 0.0, Eigen::VectorXd(), sweepValue,
+                                               solution, totalIterations);
+            totalIterations += iterations;
+        }
+
+        if (converged) {
+            value2 = value1;
+            solution2 = solution1;
+            value1 = sweepValue;
+            solution1 = solution;
         }
         else {
-            const int MAX_ITERATIONS = 100;
-            const double TOLERANCE = 1e-6;
-            bool converged = false;
+            if (solution.size() == 0)
+                *diagnostics << "DC sweep failed to solve at " << sourceName << " = " << sweepValue << std::endl;
+            else
+                *diagnostics << "Warning: DC analysis did not converge at sweep value " << sweepValue << std::endl;
+            solution1.resize(0);
+            solution2.resize(0);
+        }
+        solutions[k] = solution;
+        convergedPoints[k] = converged;
+    }
+    return totalIterations;
+}
 
-            Eigen::VectorXd lastSolution;
+// Walks the swept source from `from` (solved as fromSolution, with the point before at `previous`) to
+// target. Each step's Newton starts from a linear extrapolation of the last two solutions; the step is
+// halved when Newton fails or is slow and doubled when it is quick.
+bool Circuit::continueDcSolution(Component* sweepSource, double from, Eigen::VectorXd fromSolution, double previous,
+                                 Eigen::VectorXd previousSolution, double target, Eigen::VectorXd& solution,
+                                 size_t& totalIterations) {
+    const int FAST_ITERATIONS = 4;
+    const int SLOW_ITERATIONS = 10;
+    const int MAX_HALVINGS = 10;
+
+    double step = target - from;
+    const double minStep = std::abs(step) / (1 << MAX_HALVINGS);
+    while (true) {
+        double next = std::abs(target - from) <= std::abs(step) ? target : from + step;
+        Eigen::VectorXd seed = fromSolution;
+        if (previousSolution.size() == seed.size() && previous != from)
+            seed += (fromSolution - previousSolution) * ((next - from) / (from - previous));
+
+        int iterations = 0;
+        setSourceValue(sweepSource, next);
+        bool converged = solveDcNewton(&seed, solution, iterations);
+        totalIterations += iterations;
+        if (!converged) {
+            if (std::abs(step) <= minStep)
+                return false;
+            step /= 2;
+            continue;
+        }
+        if (next == target)
+            return true;
+
+        previous = from;
+        previousSolution = fromSolution;
+        from = next;
+        fromSolution = solution;
+        if (iterations <= FAST_ITERATIONS)
+            step *= 2;
+        else if (iterations > SLOW_ITERATIONS)
+            step /= 2;
+    }
+}
 
-            for (auto* comp : components) {
-                if (auto* diode = dynamic_cast<Diode*>(comp)) {
-                    diode->reset();
-                }
-            }
+// Newton iteration for the DC operating point at the present source values. A seed sets the nonlinear
+// devices' operating point to start from, otherwise they start from reset.
+bool Circuit::solveDcNewton(const Eigen::VectorXd* seed, Eigen::VectorXd& solution, int& iterations) {
+    const int MAX_ITERATIONS = 100;
 
-            for (int i = 0; i < MAX_ITERATIONS; ++i) {
-                buildMNAMatrix(0.0, 0.0);
-                solution = solveMNASystem();
-                if (solution.size() == 0) {
-                    std::cout << "DC sweep failed to solve at " << sourceName << " = " << sweepValue << std::endl;
-                    break;
-                }
-                if (i > 0 && (solution - lastSolution).norm() < TOLERANCE) {
-                    converged = true;
-                    break;
-                }
-                lastSolution = solution;
-                updateNonlinearComponentStates(solution, nodeIdToMnaIndex);
-            }
+    Eigen::VectorXd lastSolution;
+    if (seed) {
+        lastSolution = *seed;
+        updateNonlinearComponentStates(*seed);
+    }
+    else {
+        for (Component* comp : components)
+            if (comp->isNonlinear())
+                comp->reset();
+    }
 
-            if (!converged)
-                std::cout << "Warning: DC analysis did not converge at sweep value " << sweepValue << std::endl;
-        }
-        if (solution.size() > 0) {
-            dcSweepSolutions[sweepValue] = solution;
-        }
-        dcSweepSolutions[sweepValue] = solution;
+    int factorAge = 0;
+    for (iterations = 1; iterations <= MAX_ITERATIONS; ++iterations) {
+        buildMNAMatrix(StepContext(), iterations == 1 ? Restamp::TIME_POINT : Restamp::NEWTON_ITERATION);
+        solution = solveNewtonIteration(lastSolution, factorAge);
+        if (solution.size() == 0 || !solution.allFinite())
+            return false;
+        if (newtonConverged(solution, lastSolution))
+            return true;
+        lastSolution = solution;
+        updateNonlinearComponentStates(solution);
     }
-    std::cout << "DC Sweep complete. " << dcSweepSolutions.size() << " points calculated." << std::endl;
+    iterations = MAX_ITERATIONS;
+    return false;
 }
 
-void Circuit::performTransientAnalysis(double stopTime, double startTime, double maxTimeStep) {
+void Circuit::performTransientAnalysis(double stopTime, double startTime, double maxTimeStep, ITransientSink* sink) {
     if (maxTimeStep == 0.0)
         maxTimeStep = (stopTime - startTime) / 100;
 
@@ -609,43 +1140,23 @@ void Circuit::performTransientAnalysis(double stopTime, double startTime, double
         << "s" << std::endl;
     if (groundNodeIds.empty())
         throw std::runtime_error("No ground node detected.");
+    checkTopology(TopologyAnalysis::DC);
 
     for (Component* comp : components)
         comp->reset();
 
-    transientSolutions.clear();
+    beginTransientOutput(sink);
 
     std::cout << "Calculating DC operating point at t=0..." << std::endl;
-    std::map<int, int> nodeIdToMnaIndex;
     Eigen::VectorXd solution;
 
     if (hasNonlinearComponents) {
-        const int MAX_ITERATIONS = 100;
-        const double TOLERANCE = 1e-6;
-        bool converged = false;
-        Eigen::VectorXd lastSolution;
-        for (int i = 0; i < MAX_ITERATIONS; ++i) {
-            buildMNAMatrix(0.0, 0.0);
-            solution = solveMNASystem();
-            if (solution.size() == 0) break;
-            if (i > 0 && (solution - lastSolution).norm() < TOLERANCE) {
-                converged = true;
-                break;
-            }
-            lastSolution = solution;
-            std::map<int, int> nodeIdToMnaIndex;
-            int currentMnaIndex = 0;
-            for (int k = 0; k < nextNodeId; ++k) {
-                if (idToNodeName.count(k) && !isGround(k)) {
-                    nodeIdToMnaIndex[k] = currentMnaIndex++;
-                }
-            }
-            updateNonlinearComponentStates(solution, nodeIdToMnaIndex);
-        }
-        if(!converged) std::cout << "Warning: DC operating point did not fully converge." << std::endl;
+        int iterations = 0;
+        if (!solveDcNewton(nullptr, solution, iterations))
+            std::cout << "Warning: DC operating point did not fully converge." << std::endl;
     }
     else {
-        buildMNAMatrix(0.0, 0.0);
+        buildMNAMatrix(StepContext());
         solution = solveMNASystem();
     }
 
@@ -653,54 +1164,15 @@ void Circuit::performTransientAnalysis(double stopTime, double startTime, double
         throw std::runtime_error("ERROR: DC operating point failed to solve. Simulation stopped.");
     }
 
-    int currentMnaIndex = 0;
-    for (int i = 0; i < nextNodeId; ++i) {
-        if (idToNodeName.count(i) && !isGround(i)) {
-            nodeIdToMnaIndex[i] = currentMnaIndex++;
-        }
-    }
-    updateComponentStates(solution, nodeIdToMnaIndex);
-    transientSolutions[startTime] = solution;
+    updateComponentStates(solution);
+    storeTimePoint(startTime, solution);
     std::cout << "DC operating point calculated." << std::endl;
 
-    for (double t = startTime + maxTimeStep; t <= stopTime + 1e-9; t += maxTimeStep) {
-        if (!hasNonlinearComponents) {
-            buildMNAMatrix(t, maxTimeStep);
-            solution = solveMNASystem();
-        }
-        else {
-            const int MAX_ITERATIONS = 100;
-            const double TOLERANCE = 1e-6;
-            bool converged = false;
-            Eigen::VectorXd lastSolution;
-
-            for (int i = 0; i < MAX_ITERATIONS; ++i) {
-                buildMNAMatrix(t, maxTimeStep);
-                solution = solveMNASystem();
-                if (solution.size() == 0) break;
-
-                if (i > 0 && (solution - lastSolution).norm() < TOLERANCE) {
-                    converged = true;
-                    break;
-                }
-                lastSolution = solution;
-                updateNonlinearComponentStates(solution, nodeIdToMnaIndex);
-            }
-            if (!converged)
-                std::cout << "Warning: Transient analysis did not converge at t = " << t << "s" << std::endl;
-        }
-
-        if (solution.size() == 0)
-            throw std::runtime_error("ERROR at t = " + std::to_string(t) + "s: Simulation stopped.");
-        updateComponentStates(solution, nodeIdToMnaIndex);
-        transientSolutions[t] = solution;
-    }
-
-    std::cout << "Transient analysis complete. " << transientSolutions.size() << " time points stored." << std::endl;
-    std::cout << "Use .print to view results." << std::endl;
+    advanceTransient(startTime, stopTime, maxTimeStep, solution);
+    endTransientOutput();
 }
 
-void Circuit::runTransientAnalysis(double stopTime, double startTime, double maxTimeStep) {
+void Circuit::runTransientAnalysis(double stopTime, double startTime, double maxTimeStep, ITransientSink* sink) {
     if (maxTimeStep == 0.0)
         maxTimeStep = (stopTime - startTime) / 100;
     std::cout << "\n\t---------- Performing Transient Analysis ----------" << std::endl;
@@ -709,59 +1181,241 @@ void Circuit::runTransientAnalysis(double stopTime, double startTime, double max
 
     if (groundNodeIds.empty())
         throw std::runtime_error("No ground node detected.");
+    checkTopology(TopologyAnalysis::TRANSIENT);
 
     for (const auto& comp : components)
         comp->reset();
-    transientSolutions.clear();
+    beginTransientOutput(sink);
+
+    bool converged = false;
+    Eigen::VectorXd solution = solveTimePoint(transientStep(startTime, maxTimeStep, 0.0), converged);
+    if (!converged)
+        std::cout << "Warning: Transient analysis did not converge at t = " << startTime << "s" << std::endl;
+    if (solution.size() == 0)
+        throw std::runtime_error("ERROR at t = " + std::to_string(startTime) + "s: Simulation stopped.");
+    updateComponentStates(solution);
+    storeTimePoint(startTime, solution);
+
+    advanceTransient(startTime, stopTime, maxTimeStep, solution);
+    endTransientOutput();
+}
 
-    std::map<int, int> nodeIdToMnaIndex;
-    Eigen::VectorXd solution;
+// Transient results go either to the in-memory store or, when a sink is given, straight to the sink.
+void Circuit::beginTransientOutput(ITransientSink* sink) {
+    transientSink = sink;
+    transientPointCount = 0;
+    transientCancelled = false;
+    transientResults.clear();
+    capacitorCurrents.clear();
+    capacitorCurrentNames.clear();
+    transientCapacitors.clear();
+    if (!sink) {
+        for (const Component* comp : components) {
+            if (const auto* capacitor = dynamic_cast<const Capacitor*>(comp)) {
+                transientCapacitors.push_back(capacitor);
+                capacitorCurrentNames.push_back(capacitor->name);
+            }
+        }
+    }
+}
+
+void Circuit::storeTimePoint(double time, const Eigen::VectorXd& solution) {
+    if (transientSink) {
+        if (transientPointCount == 0)
+            transientSink->begin(getSignalNames());
+        transientSink->write(time, solution);
+    }
+    else {
+        transientResults.append(time, solution);
+        // Called after updateComponentStates(), so the capacitors hold the current of this point
+        Eigen::VectorXd currents(transientCapacitors.size());
+        for (size_t i = 0; i < transientCapacitors.size(); ++i)
+            currents(i) = transientCapacitors[i]->getCurrent();
+        capacitorCurrents.append(time, currents);
+    }
+    transientPointCount++;
+}
+
+void Circuit::endTransientOutput() {
+    if (transientSink) {
+        transientSink->end();
+        transientSink = nullptr;
+        std::cout << "Transient analysis complete. " << transientPointCount << " time points streamed." << std::endl;
+        return;
+    }
+    std::cout << "Transient analysis complete. " << transientPointCount << " time points stored." << std::endl;
+    std::cout << "Use .print to view results." << std::endl;
+}
 
-    int currentMnaIndex = 0;
-    for (int i = 0; i < nextNodeId; ++i) {
-        if (idToNodeName.count(i) && !isGround(i)) {
-            nodeIdToMnaIndex[i] = currentMnaIndex++;
+// False once the progress handler asked to stop; the caller ends the analysis after the current point.
+bool Circuit::reportProgress(double time) {
+    if (!progressHandler || progressHandler(time, transientPointCount))
+        return true;
+    transientCancelled = true;
+    std::cout << "Transient analysis cancelled at t = " << time << "s." << std::endl;
+    return false;
+}
+
+// Names of the MNA unknowns in solution order: V(<node>) for the nodes, then I(<component>).
+std::vector<std::string> Circuit::getSignalNames() const {
+    std::vector<std::string> names(matrixSize);
+    for (int i = 0; i < static_cast<int>(nodeMnaRow.size()); ++i) {
+        if (nodeMnaRow[i] != -1 && nodeRepresentative[i] == i && nodeMnaRow[i] < matrixSize)
+            names[nodeMnaRow[i]] = "V(" + nodeNames.name(i) + ")";
+    }
+    for (int id = 0; id < static_cast<int>(componentBranchRow.size()); ++id) {
+        if (componentBranchRow[id] != -1 && componentBranchRow[id] < matrixSize)
+            names[componentBranchRow[id]] = "I(" + componentNames.name(id) + ")";
+    }
+    return names;
+}
+
+// Marches from the last stored point at startTime to stopTime. With TIMESTEP=FIXED every step is
+// maxTimeStep; otherwise the step follows the truncation error and maxTimeStep is only the upper bound.
+void Circuit::advanceTransient(double startTime, double stopTime, double maxTimeStep, const Eigen::VectorXd& initial) {
+    if (!options.adaptiveStep) {
+        double hPrev = 0.0;
+        for (double t = startTime + maxTimeStep; t <= stopTime + 1e-9; t += maxTimeStep) {
+            bool converged = false;
+            Eigen::VectorXd solution = solveTimePoint(transientStep(t, maxTimeStep, hPrev), converged);
+            if (!converged)
+                std::cout << "Warning: Transient analysis did not converge at t = " << t << "s" << std::endl;
+            if (solution.size() == 0)
+                throw std::runtime_error("ERROR at t = " + std::to_string(t) + "s: Simulation stopped.");
+            updateComponentStates(solution);
+            storeTimePoint(t, solution);
+            if (!reportProgress(t))
+                return;
+            hPrev = maxTimeStep;
         }
+        return;
     }
 
-    for (double t = startTime; t <= stopTime; t += maxTimeStep) {
-        if (!hasNonlinearComponents) {
-            buildMNAMatrix(t, maxTimeStep);
-            solution = solveMNASystem();
+    const int order = options.method == IntegrationMethod::BACKWARD_EULER ? 1 : 2;
+    const double hMin = maxTimeStep * 1e-9;
+    const double hStart = maxTimeStep / 100;
+    double h = hStart;
+    double hPrev = 0.0;
+    double t = startTime;
+    int rejected = 0;
+
+    // Source corners, merged when closer than the smallest step. A merged breakpoint is hard if any of
+    // its parts is.
+    std::vector<Breakpoint> rawBreakpoints, breakpoints;
+    for (Component* comp : components)
+        comp->getBreakpoints(startTime, stopTime, rawBreakpoints);
+    std::sort(rawBreakpoints.begin(), rawBreakpoints.end(),
+              [](const Breakpoint& a, const Breakpoint& b) { return a.time < b.time; });
+    for (const Breakpoint& bp : rawBreakpoints) {
+        if (bp.time <= startTime + hMin || bp.time >= stopTime - hMin)
+            continue;
+        if (!breakpoints.empty() && bp.time - breakpoints.back().time <= hMin)
+            breakpoints.back().hard = breakpoints.back().hard || bp.hard;
+        else
+            breakpoints.push_back(bp);
+    }
+    size_t nextBreakpoint = 0;
+
+    // The last accepted points, oldest first, with room for the candidate point
+    std::vector<double> times{startTime};
+    std::vector<Eigen::VectorXd> points{initial};
+
+    while (t < stopTime - hMin) {
+        double hStep = std::min(h, stopTime - t);
+        for (Component* comp : components)
+            hStep = std::min(hStep, comp->getMaxStep(t));
+        // Land exactly on the next breakpoint, and split the approach in two rather than leave a sliver.
+        bool atBreakpoint = false;
+        double tNext = t + hStep;
+        if (nextBreakpoint < breakpoints.size()) {
+            double bp = breakpoints[nextBreakpoint].time;
+            if (tNext >= bp - hMin) {
+                tNext = bp;
+                hStep = bp - t;
+                atBreakpoint = true;
+            }
+            else if (t + 2 * hStep > bp) {
+                hStep = (bp - t) / 2;
+                tNext = t + hStep;
+            }
         }
-        else {
-            const int MAX_ITERATIONS = 100;
-            const double TOLERANCE = 1e-6;
-            bool converged = false;
-            Eigen::VectorXd lastSolution;
 
-            for (int i = 0; i < MAX_ITERATIONS; ++i) {
-                buildMNAMatrix(t, maxTimeStep);
-                solution = solveMNASystem();
-                if (solution.size() == 0) break;
+        bool converged = false;
+        Eigen::VectorXd solution = solveTimePoint(transientStep(tNext, hStep, hPrev), converged);
 
-                if (i > 0 && (solution - lastSolution).norm() < TOLERANCE) {
-                    converged = true;
-                    break;
-                }
-                lastSolution = solution;
-                updateNonlinearComponentStates(solution, nodeIdToMnaIndex);
+        if (solution.size() == 0 || !converged) {
+            if (hStep > hMin) {
+                h = std::max(hStep / 8, hMin);
+                rejected++;
+                continue;
             }
-            if (!converged)
-                std::cout << "Warning: Transient analysis did not converge at t = " << t << "s" << std::endl;
+            if (solution.size() == 0)
+                throw std::runtime_error("ERROR at t = " + std::to_string(tNext) + "s: Simulation stopped.");
+            std::cout << "Warning: Transient analysis did not converge at t = " << tNext << "s" << std::endl;
+        }
+
+        times.push_back(tNext);
+        points.push_back(solution);
+
+        // The first step from a (re)start has no history to estimate its error from; it is taken at the
+        // small starting step and h is held until a step has been checked. Until there are order + 2
+        // points the error is estimated at first order.
+        double factor = 1.0;
+        int estimateOrder = std::min(order, static_cast<int>(times.size()) - 2);
+        if (estimateOrder >= 1) {
+            double ratio = truncationErrorRatio(times, points, estimateOrder);
+            factor = ratio > 0.0 ? 0.9 * std::pow(ratio, -1.0 / (estimateOrder + 1)) : 2.0;
+            if (ratio > 1.0 && hStep > hMin) {
+                times.pop_back();
+                points.pop_back();
+                h = std::max(hStep * std::max(factor, 0.125), hMin);
+                rejected++;
+                continue;
+            }
+        }
+        if (static_cast<int>(times.size()) == order + 2) {
+            times.erase(times.begin());
+            points.erase(points.begin());
+        }
+
+        t = tNext;
+        updateComponentStates(solution);
+        storeTimePoint(t, solution);
+        if (!reportProgress(t))
+            return;
+        hPrev = hStep;
+
+        // Past a discontinuity the old points say nothing about the new derivatives, so the history
+        // restarts at a hard breakpoint with a small step (and Gear-2 with one backward Euler step). At a
+        // soft one the step control carries on.
+        if (atBreakpoint && breakpoints[nextBreakpoint++].hard) {
+            times.assign(1, t);
+            points.assign(1, solution);
+            hPrev = 0.0;
+            h = std::min(h, hStart);
+            continue;
         }
-        if (solution.size() == 0)
-            throw std::runtime_error("ERROR at t = " + std::to_string(t) + "s: Simulation stopped.");
-        updateComponentStates(solution, nodeIdToMnaIndex);
-        transientSolutions[t] = solution;
+
+        // Small changes keep h as it is, so the linear fast path can keep its factorization.
+        if (factor >= 2.0)
+            h = std::min(2 * h, maxTimeStep);
+        else if (factor < 1.0)
+            h = std::max(hStep * factor, hMin);
     }
-    std::cout << "Transient analysis complete. " << transientSolutions.size() << " time points stored." << std::endl;
-    std::cout << "Use .print to view results." << std::endl;
+
+    if (rejected > 0)
+        std::cout << rejected << " time steps were rejected and retried with a smaller step." << std::endl;
 }
 
-std::pair<std::string, std::vector<double>> Circuit::getTransientResults(const std::string& parameter) {
-    std::vector<double> parameterValues;
-    std::string plotTitle = "Transient Analysis";
+const std::vector<double>& Circuit::getTransientTimePoints() const {
+    return transientResults.times();
+}
+
+// Maps a V(node) or I(component) probe to its column in the result store, -1 for ground or an unknown
+// probe. Returns false when the probe is not in either format.
+bool Circuit::resolveProbe(const std::string& parameter, std::string& plotTitle, int& column) const {
+    plotTitle = "Transient Analysis";
+    column = -1;
 
     // Parse the parameter string
     int nodeToPlot = -1;
@@ -786,7 +1440,7 @@ std::pair<std::string, std::vector<double>> Circuit::getTransientResults(const s
             plotTitle = "Voltage at Node " + std::to_string(nodeToPlot);
         } catch (const std::invalid_argument& e) {
             std::cerr << "Invalid node number: " << e.what() << std::endl;
-            return {plotTitle, parameterValues};
+            return false;
         }
     } else if (cMatch.hasMatch()) {
         isCurrent = true;
@@ -794,45 +1448,35 @@ std::pair<std::string, std::vector<double>> Circuit::getTransientResults(const s
         plotTitle = "Current through " + componentToPlot;
     } else {
         std::cerr << "Invalid parameter format. Use V(node) or I(component)." << std::endl;
-        return {plotTitle, parameterValues};
+        return false;
     }
 
-    // Map component names to their current indices if needed
-    std::map<std::string, int> componentCurrentIndices;
-    int currentIdx = nextNodeId;
-    for (const auto& comp : components) {
-        if (comp->needsCurrentUnknown()) {
-            componentCurrentIndices[comp->getName()] = currentIdx++;
-        }
-    }
+    if (isVoltage && nodeToPlot != 0 && nodeRow(nodeToPlot) != -1)
+        column = nodeRow(nodeToPlot);
+    else if (isCurrent && branchRow(componentToPlot) != -1)
+        column = branchRow(componentToPlot);
+    return true;
+}
 
-    // Iterate through the stored solutions and extract the values
-    std::map<int, int> nodeIdToMnaIndex;
-    int currentMnaIndex = 0;
-    for (int i = 0; i < nextNodeId; ++i) {
-        if (idToNodeName.count(i) && !isGround(i)) {
-            nodeIdToMnaIndex[i] = currentMnaIndex++;
-        }
-    }
+int Circuit::getProbeColumn(const std::string& parameter) const {
+    std::string plotTitle;
+    int column = -1;
+    resolveProbe(parameter, plotTitle, column);
+    return column;
+}
 
-    for (const auto& pair : transientSolutions) {
-        const Eigen::VectorXd& solution = pair.second;
-        if (isVoltage) {
-            if (nodeToPlot == 0) { // Ground node
-                parameterValues.push_back(0.0);
-            } else if (nodeIdToMnaIndex.count(nodeToPlot)) {
-                parameterValues.push_back(solution(nodeIdToMnaIndex.at(nodeToPlot)));
-            } else {
-                parameterValues.push_back(0.0); // Node not found
-            }
-        } else if (isCurrent) {
-            if (componentCurrentIndices.count(componentToPlot)) {
-                parameterValues.push_back(solution(componentCurrentIndices.at(componentToPlot)));
-            } else {
-                parameterValues.push_back(0.0); // Component not found or has no current
-            }
-        }
-    }
+std::pair<std::string, std::vector<double>> Circuit::getTransientResults(const std::string& parameter) {
+    std::vector<double> parameterValues;
+    std::string plotTitle;
+    int column = -1;
+    if (!resolveProbe(parameter, plotTitle, column))
+        return {plotTitle, parameterValues};
+
+    // A probe is one column of the result store; ground and unknown probes read as 0.
+    if (column != -1 && column < transientResults.signalCount())
+        parameterValues = transientResults.signal(column);
+    else
+        parameterValues.assign(transientResults.size(), 0.0);
 
     return {plotTitle, parameterValues};
 }
@@ -842,19 +1486,11 @@ std::pair<std::string, std::vector<double>> Circuit::getTransientResults(const s
 
 // -------------------------------- Output Results --------------------------------
 void Circuit::printTransientResults(const std::vector<std::string>& variablesToPrint) const {
-    if (transientSolutions.empty())
+    if (transientResults.empty())
         throw std::runtime_error("No analysis results found. Run .TRAN or .DC first.");
     if (groundNodeIds.empty())
         throw std::runtime_error("No ground node detected.");
 
-    std::map<int, int> nodeIdToMnaIndex;
-    int currentMnaIndex = 0;
-    for (int i = 0; i < nextNodeId; ++i) {
-        if (idToNodeName.count(i) && !isGround(i)) {
-            nodeIdToMnaIndex.at(i) = currentMnaIndex++;
-        }
-    }
-
     struct PrintJob {
         std::string header;
         enum class Type { VOLTAGE, MNA_CURRENT, RESISTOR_CURRENT, CAPACITOR_CURRENT } type;
@@ -871,23 +1507,30 @@ void Circuit::printTransientResults(const std::vector<std::string>& variablesToP
 
         if (type == "V") {
             if (!hasNode(name)) throw std::runtime_error("Node " + name + " not found.");
-            int nodeID = nodeNameToId.at(name);
-            int solutionIndex = isGround(nodeID) ? -1 : nodeIdToMnaIndex.at(nodeID);
+            int nodeID = nodeNames.find(name);
+            int solutionIndex = nodeRow(nodeID);
             printJobs.push_back({var, PrintJob::Type::VOLTAGE, solutionIndex, nullptr});
 
         }
         else if (type == "I") {
-            if (componentCurrentIndices.count(name))
-                printJobs.push_back({var, PrintJob::Type::MNA_CURRENT, componentCurrentIndices.at(name), nullptr});
+            if (branchRow(name) != -1)
+                printJobs.push_back({var, PrintJob::Type::MNA_CURRENT, branchRow(name), nullptr});
 
             else {
-                if (componentCurrentIndices.count(name))
-                    printJobs.push_back({var, PrintJob::Type::MNA_CURRENT, componentCurrentIndices.at(name), nullptr});
+                if (branchRow(name) != -1)
+                    printJobs.push_back({var, PrintJob::Type::MNA_CURRENT, branchRow(name), nullptr});
                 else {
                     Component* comp = getComponent(name);
                     if (!comp) throw std::runtime_error("Component " + name + " not found.");
                     if (dynamic_cast<Resistor*>(comp)) printJobs.push_back({var, PrintJob::Type::RESISTOR_CURRENT, -1, comp});
-                    else if (dynamic_cast<Capacitor*>(comp)) printJobs.push_back({var, PrintJob::Type::CAPACITOR_CURRENT, -1, comp});
+                    else if (dynamic_cast<Capacitor*>(comp)) {
+                        auto it = std::find(capacitorCurrentNames.begin(), capacitorCurrentNames.end(), name);
+                        if (it == capacitorCurrentNames.end())
+                            std::cout << "Warning: Capacitor '" << name << "' was added after the analysis." << std::endl;
+                        else
+                            printJobs.push_back({var, PrintJob::Type::CAPACITOR_CURRENT,
+                                                 static_cast<int>(it - capacitorCurrentNames.begin()), comp});
+                    }
                     else std::cout << "Warning: Current for component type of '" << name << "' cannot be calculated." << std::endl;
                 }
             }
@@ -901,43 +1544,35 @@ void Circuit::printTransientResults(const std::vector<std::string>& variablesToP
         std::cout << std::setw(14) << job.header;
     std::cout << std::endl;
 
-    auto itPrev = transientSolutions.begin();
-    for (auto it = transientSolutions.begin(); it != transientSolutions.end(); ++it) {
-        double t = it->first;
-        const Eigen::VectorXd& solution = it->second;
+    auto nodeVoltage = [&](int nodeId, size_t k) {
+        int row = nodeRow(nodeId);
+        return row == -1 ? 0.0 : transientResults.value(k, row);
+    };
+
+    const std::vector<double>& times = transientResults.times();
+    for (size_t k = 0; k < transientResults.size(); ++k) {
+        double t = times[k];
 
         std::cout << std::left << std::fixed << std::setprecision(6) << std::setw(14) << t;
 
         for (const auto& job : printJobs) {
             double result = 0.0;
             if (job.type == PrintJob::Type::VOLTAGE || job.type == PrintJob::Type::MNA_CURRENT)
-                result = (job.index == -1) ? 0.0 : solution(job.index);
+                result = (job.index == -1) ? 0.0 : transientResults.value(k, job.index);
             else {
                 int node1 = job.component_ptr->node1;
                 int node2 = job.component_ptr->node2;
-                double v1 = isGround(node1) ? 0.0 : solution(nodeIdToMnaIndex.at(node1));
-                double v2 = isGround(node2) ? 0.0 : solution(nodeIdToMnaIndex.at(node2));
+                double v1 = nodeVoltage(node1, k);
+                double v2 = nodeVoltage(node2, k);
 
                 if (job.type == PrintJob::Type::RESISTOR_CURRENT)
                     result = (v1 - v2) / job.component_ptr->value;
-                else if (job.type == PrintJob::Type::CAPACITOR_CURRENT) {
-                    if (it == transientSolutions.begin())
-                        result = 0.0;
-                    else {
-                        const Eigen::VectorXd& prevSolution = itPrev->second;
-                        double v1_prev = isGround(node1) ? 0.0 : prevSolution(nodeIdToMnaIndex.at(node1));
-                        double v2_prev = isGround(node2) ? 0.0 : prevSolution(nodeIdToMnaIndex.at(node2));
-                        double vCap_prev = v1_prev - v2_prev;
-                        double vCap_now = v1 - v2;
-                        double h = t - itPrev->first;
-                        if (h > 0) result = job.component_ptr->value * (vCap_now - vCap_prev) / h;
-                    }
-                }
+                else if (job.type == PrintJob::Type::CAPACITOR_CURRENT)
+                    result = capacitorCurrents.value(k, job.index);
             }
             std::cout << std::setw(14) << result;
         }
         std::cout << std::endl;
-        itPrev = it;
     }
 }
 
@@ -948,14 +1583,6 @@ void Circuit::printDcSweepResults(const std::string& sourceName, const std::stri
     char varType = variable.front();
     std::string varName = variable.substr(2, variable.length() - 3);
 
-    std::map<int, int> nodeIdToMnaIndex;
-    int currentMnaIndex = 0;
-    for (int i = 0; i < nextNodeId; ++i) {
-        if (idToNodeName.count(i) && !isGround(i)) {
-            nodeIdToMnaIndex[i] = currentMnaIndex++;
-        }
-    }
-
     std::cout << "\n---- DC Sweep Results ----" << std::endl;
     std::cout << std::left << std::setw(14) << sourceName;
     std::cout << std::setw(14) << variable << std::endl;
@@ -965,11 +1592,16 @@ void Circuit::printDcSweepResults(const std::string& sourceName, const std::stri
         double sweepValue = pair.first;
         const Eigen::VectorXd& solution = pair.second;
         double result = 0.0;
+        if (solution.size() != matrixSize) {
+            std::cout << std::left << std::fixed << std::setprecision(6);
+            std::cout << std::setw(14) << sweepValue << "(no solution)" << std::endl;
+            continue; // sweep point that failed to solve
+        }
 
         if (varType == 'V') {
             int nodeID = getNodeId(varName);
             if(nodeID == -1) throw std::runtime_error("Node not found.");
-            result = isGround(nodeID) ? 0.0 : solution(nodeIdToMnaIndex.at(nodeID));
+            result = nodeRow(nodeID) == -1 ? 0.0 : solution(nodeRow(nodeID));
         }
         else {
             Component* comp = getComponent(varName);
@@ -978,8 +1610,8 @@ void Circuit::printDcSweepResults(const std::string& sourceName, const std::stri
                 throw std::runtime_error(errorMsg);
             }
             if (comp->needsCurrentUnknown()) {
-                if (componentCurrentIndices.count(varName))
-                    result = solution(componentCurrentIndices.at(varName));
+                if (branchRow(varName) != -1)
+                    result = solution(branchRow(varName));
                 else {
                     std::cout << "Warning: Could not find current index for '" << varName << "'. Skipping." <<
                         std::endl;
@@ -988,19 +1620,10 @@ void Circuit::printDcSweepResults(const std::string& sourceName, const std::stri
             }
             else {
                 if (dynamic_cast<Resistor*>(comp)) {
-                    int node1 = comp->node1;
-                    int node2 = comp->node2;
-
-                    double v1 = 0.0;
-                    if (nodeIdToMnaIndex.count(node1)) {
-                        int index1 = nodeIdToMnaIndex.at(node1);
-                        v1 = solution(index1);
-                    }
-                    double v2 = 0.0;
-                    if (nodeIdToMnaIndex.count(node2)) {
-                        int index2 = nodeIdToMnaIndex.at(node2);
-                        v2 = solution(index2);
-                    }
+                    int index1 = nodeRow(comp->node1);
+                    int index2 = nodeRow(comp->node2);
+                    double v1 = index1 == -1 ? 0.0 : solution(index1);
+                    double v2 = index2 == -1 ? 0.0 : solution(index2);
                     result = (v1 - v2) / comp->value;
                 }
                 else if (dynamic_cast<Capacitor*>(comp))
@@ -1020,6 +1643,45 @@ void Circuit::printDcSweepResults(const std::string& sourceName, const std::stri
 }
 
 
+// Writes the stored results of the last TRAN or DC analysis as a binary .raw file.
+void Circuit::saveRawFile(const std::string& path, const std::string& analysis) const {
+    std::string title = fs::path(currentFilePath).stem().string();
+    std::string kind = analysis;
+    std::transform(kind.begin(), kind.end(), kind.begin(), [](unsigned char c) { return std::toupper(c); });
+
+    if (kind == "TRAN") {
+        if (transientResults.empty())
+            throw std::runtime_error("No transient results found. Run .TRAN first.");
+        RawFileWriter writer(path, title);
+        writer.begin(getSignalNames());
+        const std::vector<double>& times = transientResults.times();
+        for (size_t k = 0; k < times.size(); ++k)
+            writer.write(times[k], transientResults.point(k));
+        writer.end();
+        std::cout << times.size() << " transient points written to " << path << std::endl;
+    }
+    else if (kind == "DC") {
+        if (dcSweepSolutions.empty())
+            throw std::runtime_error("No DC sweep results found. Run .DC first.");
+        Component* source = getComponent(dcSweepSource);
+        const char* axisType = dynamic_cast<CurrentSource*>(source) ? "current" : "voltage";
+        RawFileWriter writer(path, title, "DC transfer characteristic", dcSweepSource, axisType);
+        std::vector<std::string> names = getSignalNames();
+        writer.begin(names);
+        size_t written = 0;
+        for (const auto& pair : dcSweepSolutions) {
+            if (pair.second.size() != static_cast<int>(names.size()))
+                continue; // sweep point that failed to solve
+            writer.write(pair.first, pair.second);
+            written++;
+        }
+        writer.end();
+        std::cout << written << " DC sweep points written to " << path << std::endl;
+    }
+    else
+        throw std::runtime_error("Unknown analysis '" + analysis + "'. Use TRAN or DC.");
+}
+
 void Circuit::setWirelessSourceVoltage(double voltage) {
     for (const auto& comp : components) {
         if (comp->getType() == Component::Type::VOLTAGE_SOURCE) {
@@ -1032,4 +1694,90 @@ void Circuit::setWirelessSourceVoltage(double voltage) {
     }
 }
 
-// -------------------------------- Output Results --------------------------------
\ No newline at end of file
+// -------------------------------- Output Results --------------------------------
+
+
+// -------------------------------- Simulator Options --------------------------------
+// Whole-token integer, so "4abc" is rejected rather than read as 4
+static bool parseInteger(const std::string& text, int& value) {
+    size_t pos = 0;
+    try {
+        value = std::stoi(text, &pos);
+    } catch (const std::exception&) {
+        return false;
+    }
+    return pos == text.size();
+}
+
+void Circuit::setOption(const std::string& name, const std::string& value) {
+    std::string key = name, val = value;
+    std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return std::toupper(c); });
+    std::transform(val.begin(), val.end(), val.begin(), [](unsigned char c) { return std::toupper(c); });
+
+    if (key == "SOLVER") {
+        if (val == "DENSE")
+            options.solver = MNAMatrix::Backend::DENSE;
+        else if (val == "SPARSE")
+            options.solver = MNAMatrix::Backend::SPARSE;
+        else
+            throw std::runtime_error("Invalid value for SOLVER. Use DENSE or SPARSE.");
+    }
+    else if (key == "METHOD") {
+        if (val == "EULER" || val == "BE")
+            options.method = IntegrationMethod::BACKWARD_EULER;
+        else if (val == "TRAP" || val == "TRAPEZOIDAL")
+            options.method = IntegrationMethod::TRAPEZOIDAL;
+        else if (val == "GEAR" || val == "GEAR2" || val == "BDF2")
+            options.method = IntegrationMethod::GEAR2;
+        else
+            throw std::runtime_error("Invalid value for METHOD. Use EULER, TRAP or GEAR.");
+    }
+    else if (key == "TIMESTEP") {
+        if (val == "ADAPTIVE")
+            options.adaptiveStep = true;
+        else if (val == "FIXED")
+            options.adaptiveStep = false;
+        else
+            throw std::runtime_error("Invalid value for TIMESTEP. Use ADAPTIVE or FIXED.");
+    }
+    else if (key == "THREADS") {
+        int threads = -1;
+        if (!parseInteger(val, threads) || threads < 0)
+            throw std::runtime_error("Invalid value for THREADS. Use 0 for one per core or a thread count.");
+        options.threads = threads;
+    }
+    else if (key == "BYPASS") {
+        if (val == "ON" || val == "1")
+            options.bypass = true;
+        else if (val == "OFF" || val == "0")
+            options.bypass = false;
+        else
+            throw std::runtime_error("Invalid value for BYPASS. Use ON or OFF.");
+    }
+    else if (key == "LUREUSE") {
+        int reuse = 0;
+        if (!parseInteger(val, reuse) || reuse < 1)
+            throw std::runtime_error("Invalid value for LUREUSE. Use the number of Newton iterations per factorization, 1 or more.");
+        options.luReuse = reuse;
+    }
+    else if (key == "RELTOL" || key == "VNTOL" || key == "ABSTOL" || key == "TRTOL") {
+        double tol = 0.0;
+        try {
+            tol = parseSpiceValue(val);
+        } catch (const std::exception&) {
+            throw std::runtime_error("Invalid value for " + key + ".");
+        }
+        if (tol <= 0.0)
+            throw std::runtime_error(key + " must be greater than zero.");
+        if (key == "RELTOL") options.reltol = tol;
+        else if (key == "VNTOL") options.vntol = tol;
+        else if (key == "ABSTOL") options.abstol = tol;
+        else options.trtol = tol;
+    }
+    else
+        throw std::runtime_error("Unknown option '" + name + "'.");
+
+    linearFactored = false;
+    std::cout << "Option " << key << " set to " << val << "." << std::endl;
+}
+// -------------------------------- Simulator Options --------------------------------
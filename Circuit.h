@@ -5,10 +5,24 @@
 #include <fstream>
 #include <filesystem>
 #include <set>
+#include <functional>
 #include "component.h"
 #include "ComponentFactory.h"
+#include "MNAMatrix.h"
+#include "MNASolver.h"
+#include "SimulationOptions.h"
+#include "TransientResultStore.h"
+#include "TransientSink.h"
+#include "RawFileWriter.h"
+#include "TopologyCheck.h"
+#include "DisjointSet.h"
+#include "StringInterner.h"
 
 double parseSpiceValue(const std::string& valueStr);
+// Parses PULSE(...) and PWL(...) source functions into numericParams, with the kind in stringParams[0].
+// Returns false when firstToken starts neither of them.
+bool parseSourceFunction(const std::string& firstToken, std::istream& in, std::vector<double>& numericParams,
+                         std::vector<std::string>& stringParams);
 
 // New class for a wireless voltage source
 class WirelessVoltageSource : public VoltageSource {
@@ -17,6 +31,7 @@ private:
 public:
     WirelessVoltageSource(const std::string& n, int n1, int n2)
         : VoltageSource(n, n1, n2, nullptr) {}
+    WirelessVoltageSource* clone() const override { return new WirelessVoltageSource(*this); }
 
     virtual double getVoltage(double time) const {
         return networkVoltage;
@@ -61,42 +76,119 @@ public:
 
     // Analysis
     void performDCAnalysis(const std::string& , double , double , double );
-    void performTransientAnalysis(double, double, double);
+    void performTransientAnalysis(double, double, double, ITransientSink* sink = nullptr);
     void printTransientResults(const std::vector<std::string>&) const;
     void printDcSweepResults(const std::string&, const std::string&) const;
+    void saveRawFile(const std::string& path, const std::string& analysis) const;
     void addLabel(const std::string&, const std::string&);
 
     std::pair<std::string, std::vector<double>> getTransientResults(const std::string& parameter);
+    const std::vector<double>& getTransientTimePoints() const;
+    std::vector<std::string> getSignalNames() const;
+    // Result store column of a V(node)/I(component) probe, -1 for ground or an unknown probe. The
+    // columns are known once an analysis has started.
+    int getProbeColumn(const std::string& parameter) const;
+    const TransientResultStore& getTransientResultStore() const { return transientResults; }
     //std::pair<std::string, std::vector<double>>/////////////////////////////////////////////////////////////
-    void runTransientAnalysis(double startTime, double stopTime, double stepTime);
+    void runTransientAnalysis(double startTime, double stopTime, double stepTime, ITransientSink* sink = nullptr);
     void setWirelessSourceVoltage(double voltage);
 
+    // Simulator options
+    void setOption(const std::string& name, const std::string& value);
+    const SimulationOptions& getOptions() const { return options; }
+
+    // Independent copy of the netlist (components, nodes, grounds, labels, options) without results or
+    // solver state, so an analysis can run on it while this circuit keeps being edited.
+    std::unique_ptr<Circuit> snapshot() const;
+    // Called after every accepted transient time point with its time and the number of points so far.
+    // Returning false stops the analysis there; the points up to it are kept and wasCancelled() is set.
+    using ProgressHandler = std::function<bool(double time, size_t points)>;
+    void setProgressHandler(ProgressHandler handler) { progressHandler = std::move(handler); }
+    bool wasCancelled() const { return transientCancelled; }
+
 private:
-    void buildMNAMatrix(double, double);
+    // How much of the MNA system buildMNAMatrix has to restamp
+    enum class Restamp {
+        TIME_POINT,       // new time point or sweep value: everything above the cached static stamps
+        NEWTON_ITERATION, // same time point as the last build: only the iteration stamps
+        RHS_ONLY          // A is already factorized, only b is rebuilt
+    };
+
+    void buildMNAMatrix(const StepContext& step, Restamp restamp = Restamp::TIME_POINT);
     Eigen::VectorXd solveMNASystem();
-    void updateComponentStates(const Eigen::VectorXd&, const std::map<int, int>&);
-    void updateNonlinearComponentStates(const Eigen::VectorXd&, const std::map<int, int>&);
-    void mergeNodes(int sourceNodeI, int destNodeId);
+    Eigen::VectorXd solveLinearTimeStep(const StepContext& step);
+    StepContext transientStep(double time, double h, double hPrev) const;
+    Eigen::VectorXd solveTimePoint(const StepContext& step, bool& converged);
+    Eigen::VectorXd solveNewtonIteration(const Eigen::VectorXd& lastSolution, int& factorAge);
+    bool newtonConverged(const Eigen::VectorXd& solution, const Eigen::VectorXd& lastSolution) const;
+    double truncationErrorRatio(const std::vector<double>& times, const std::vector<Eigen::VectorXd>& points, int order) const;
+    void advanceTransient(double startTime, double stopTime, double maxTimeStep, const Eigen::VectorXd& initial);
+    void beginTransientOutput(ITransientSink* sink);
+    void storeTimePoint(double time, const Eigen::VectorXd& solution);
+    void endTransientOutput();
+    size_t sweepDcPoints(const std::string& sourceName, const std::vector<double>& sweepValues, size_t begin,
+                         size_t end, std::vector<Eigen::VectorXd>& solutions, std::vector<char>& convergedPoints);
+    bool continueDcSolution(Component* sweepSource, double from, Eigen::VectorXd fromSolution, double previous,
+                            Eigen::VectorXd previousSolution, double target, Eigen::VectorXd& solution,
+                            size_t& totalIterations);
+    bool solveDcNewton(const Eigen::VectorXd* seed, Eigen::VectorXd& solution, int& iterations);
+    static bool setSourceValue(Component* source, double value);
+    bool reportProgress(double time);
+    bool resolveProbe(const std::string& parameter, std::string& plotTitle, int& column) const;
+    void checkTopology(TopologyAnalysis analysis);
+    void compileStamps();
+    void updateComponentStates(const Eigen::VectorXd&);
+    void updateNonlinearComponentStates(const Eigen::VectorXd&);
+    void mergeNodes(int nodeA, int nodeB);
+    std::vector<int> resolveNodes() const;
+    int nodeRow(int nodeId) const;
+    int branchRow(const std::string& componentName) const;
+    void topologyChanged();
     bool isGround(int nodeId) const;
 
     // circuit datas
     std::vector<Component*> components;
-    std::map<std::string, int> nodeNameToId;
-    std::map<int, std::string> idToNodeName;
-    int nextNodeId;
+    StringInterner nodeNames;           // node name <-> node id
+    StringInterner componentNames;      // component name <-> component id, kept after a deletion
+    std::vector<Component*> componentById; // nullptr for deleted components
+    DisjointSet nodeSets;       // node ids joined by connectNodes(), resolved by resolveNodes()
     std::set<int> groundNodeIds;
 
     // MNA Matrix data
-    Eigen::MatrixXd A_mna;
+    bool stampsCompiled;        // component stamp indices are resolved for the current topology
+    bool dcTopologyChecked;     // checkTopology() passed for the current topology
+    bool transientTopologyChecked;
+    int matrixSize;
+    MNAMatrix A_mna;
     Eigen::VectorXd b_mna;
+    Eigen::VectorXd b_timeStep; // b after the time-step stamps, reused across Newton iterations
+    bool staticStamped;         // A_mna holds a valid STATIC layer for the current topology
+    MNASolver mnaSolver;
+    bool linearFactored;       // mnaSolver holds the transient matrix of factoredStep
+    std::ostream* diagnostics; // solver and sweep messages, std::cout except on DC sweep workers
+    StepContext factoredStep;
     int numCurrentUnknowns;
-    std::map<std::string, int> componentCurrentIndices; // component name -> MNA component index
-    std::map<double, Eigen::VectorXd> transientSolutions;//std::map<double, Eigen::VectorXd> transientSolutions;
+    // Compiled view of the topology, built by compileStamps() and shared by the analyses and result queries
+    std::vector<int> nodeRepresentative;                // node id -> node it was merged into
+    std::vector<int> nodeMnaRow;                        // node id -> MNA row, -1 for ground
+    std::vector<int> componentBranchRow;                // component id -> MNA row of its current, -1 for none
+    TransientResultStore transientResults;
+    // Capacitor currents are no MNA unknowns, so they are recorded next to the results, one column per
+    // capacitor in transientCapacitors order
+    TransientResultStore capacitorCurrents;
+    std::vector<std::string> capacitorCurrentNames;
+    std::vector<const Capacitor*> transientCapacitors; // valid while an analysis runs
+    ITransientSink* transientSink;  // set for the duration of a streaming transient analysis
+    size_t transientPointCount;
+    bool transientCancelled;
+    ProgressHandler progressHandler;
     std::map<double, Eigen::VectorXd> dcSweepSolutions;
+    std::string dcSweepSource;
 
     // State and file management
     std::string currentFilePath;
     bool hasNonlinearComponents; // Diode
+    SimulationOptions options;
 
     std::map<std::string, std::set<int>> labelToNodes;
 };
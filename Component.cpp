@@ -5,13 +5,16 @@ Resistor::Resistor(const std::string& n, int n1, int n2, double v)
     : Component(Type::RESISTOR, n, n1, n2, v) {}
 
 Capacitor::Capacitor(const std::string& n, int n1, int n2, double v)
-    : Component(Type::CAPACITOR, n, n1, n2, v), V_prev(0.0) {}
+    : Component(Type::CAPACITOR, n, n1, n2, v), V_prev(0.0), V_prev2(0.0), I_prev(0.0), G_eq(0.0), I_eq(0.0) {}
 
 Inductor::Inductor(const std::string& n, int n1, int n2, double v)
-    : Component(Type::INDUCTOR, n, n1, n2, v), I_prev(0.0) {}
+    : Component(Type::INDUCTOR, n, n1, n2, v), I_prev(0.0), I_prev2(0.0), V_prev(0.0) {}
 
 Diode::Diode(const std::string& n, int n1, int n2, double is, double et, double vt)
-    : Component(Type::DIODE, n, n1, n2, 0.0), Is(is), eta(et), Vt(vt), V_prev(0.7) {}
+    : Component(Type::DIODE, n, n1, n2, 0.0), Is(is), Vt(vt), eta(et), V_prev(V_INITIAL), limited(false),
+      hasStamp(false), stampBypassed(false), V_lin(0.0), I_lin(0.0), G_lin(0.0) {
+    Vcrit = eta * Vt * std::log(eta * Vt / (std::sqrt(2.0) * Is));
+}
 
 VoltageSource::VoltageSource(const std::string& n, int n1, int n2, std::unique_ptr<IWaveformStrategy> wf)
     : Component(Type::VOLTAGE_SOURCE, n, n1, n2, 0.0), waveForm(std::move(wf)) {}
@@ -19,6 +22,12 @@ VoltageSource::VoltageSource(const std::string& n, int n1, int n2, std::unique_p
 CurrentSource::CurrentSource(const std::string& n, int n1, int n2, std::unique_ptr<IWaveformStrategy> wf)
     : Component(Type::CURRENT_SOURCE, n, n1, n2, 0.0), waveForm(std::move(wf)) {}
 
+VoltageSource::VoltageSource(const VoltageSource& other)
+    : Component(other), waveForm(other.waveForm ? other.waveForm->clone() : nullptr) {}
+
+CurrentSource::CurrentSource(const CurrentSource& other)
+    : Component(other), waveForm(other.waveForm ? other.waveForm->clone() : nullptr) {}
+
 VCVS::VCVS(const std::string& n, int n1, int n2, int c_n1, int c_n2, double g)
     : Component(Type::VCVS, n, n1, n2, 0.0), ctrlNode1(c_n1), ctrlNode2(c_n2), gain(g) {}
 
@@ -33,302 +42,437 @@ CCCS::CCCS(const std::string& n, int n1, int n2, const std::string &c_name, doub
 // -------------------------------- Constructor impementation --------------------------------
 
 
+// -------------------------------- Stamp index compilation --------------------------------
+static int mnaIndexOf(const std::vector<int>& nodeMnaRow, int nodeId) {
+    return nodeId >= 0 && nodeId < static_cast<int>(nodeMnaRow.size()) ? nodeMnaRow[nodeId] : -1;
+}
+
+static int branchIndexOf(const StringInterner& componentNames, const std::vector<int>& branchRows,
+                         const std::string& compName) {
+    int componentId = componentNames.find(compName);
+    return componentId != -1 && componentId < static_cast<int>(branchRows.size()) ? branchRows[componentId] : -1;
+}
+
+void Component::compileStamps(const std::vector<int>& nodeMnaRow, const StringInterner& /*componentNames*/,
+                              const std::vector<int>& /*branchRows*/, int idx) {
+    mna1 = mnaIndexOf(nodeMnaRow, node1);
+    mna2 = mnaIndexOf(nodeMnaRow, node2);
+    branch = idx;
+}
+
+void VCVS::compileStamps(const std::vector<int>& nodeMnaRow, const StringInterner& componentNames,
+                         const std::vector<int>& branchRows, int idx) {
+    Component::compileStamps(nodeMnaRow, componentNames, branchRows, idx);
+    ctrlMna1 = mnaIndexOf(nodeMnaRow, ctrlNode1);
+    ctrlMna2 = mnaIndexOf(nodeMnaRow, ctrlNode2);
+}
+
+void VCCS::compileStamps(const std::vector<int>& nodeMnaRow, const StringInterner& componentNames,
+                         const std::vector<int>& branchRows, int idx) {
+    Component::compileStamps(nodeMnaRow, componentNames, branchRows, idx);
+    ctrlMna1 = mnaIndexOf(nodeMnaRow, ctrlNode1);
+    ctrlMna2 = mnaIndexOf(nodeMnaRow, ctrlNode2);
+}
+
+void CCVS::compileStamps(const std::vector<int>& nodeMnaRow, const StringInterner& componentNames,
+                         const std::vector<int>& branchRows, int idx) {
+    Component::compileStamps(nodeMnaRow, componentNames, branchRows, idx);
+    ctrlBranch = branchIndexOf(componentNames, branchRows, ctrlCompName);
+    if (ctrlBranch == -1)
+        std::cerr << "ERROR: Controlling component '" << ctrlCompName << "' for CCVS '" << name << "' not found or has no current." << std::endl;
+}
+
+void CCCS::compileStamps(const std::vector<int>& nodeMnaRow, const StringInterner& componentNames,
+                         const std::vector<int>& branchRows, int idx) {
+    Component::compileStamps(nodeMnaRow, componentNames, branchRows, idx);
+    ctrlBranch = branchIndexOf(componentNames, branchRows, ctrlCompName);
+    if (ctrlBranch == -1)
+        std::cerr << "ERROR: Controlling component '" << ctrlCompName << "' for CCCS '" << name << "' not found or has no current." << std::endl;
+}
+// -------------------------------- Stamp index compilation --------------------------------
+
+
 // -------------------------------- Update state implementation --------------------------------
-void Capacitor::updateState(const Eigen::VectorXd& solution, const std::map<std::string, int>& ci, const std::map<int, int>& nodeIdToMnaIndex) {
+void Capacitor::updateState(const Eigen::VectorXd& solution) {
     double v1 = 0.0, v2 = 0.0;
 
-    bool n1_is_ground = !nodeIdToMnaIndex.count(node1);
-    bool n2_is_ground = !nodeIdToMnaIndex.count(node2);
+    bool n1_is_ground = mna1 == -1;
+    bool n2_is_ground = mna2 == -1;
 
     if (!n1_is_ground) {
-        v1 = solution(nodeIdToMnaIndex.at(node1));
+        v1 = solution(mna1);
     }
     if (!n2_is_ground) {
-        v2 = solution(nodeIdToMnaIndex.at(node2));
+        v2 = solution(mna2);
     }
 
+    V_prev2 = V_prev;
     V_prev = v1 - v2;
+    I_prev = G_eq * V_prev - I_eq;
 }
 
-void Inductor::updateState(const Eigen::VectorXd& solution, const std::map<std::string, int>& ci, const std::map<int, int>& nodeIdToMnaIndex) {
-    auto it = ci.find(name);
-    if (it != ci.end()) {
-        I_prev = solution(it->second);
+void Inductor::updateState(const Eigen::VectorXd& solution) {
+    if (branch != -1) {
+        I_prev2 = I_prev;
+        I_prev = solution(branch);
     }
+    V_prev = (mna1 != -1 ? solution(mna1) : 0.0) - (mna2 != -1 ? solution(mna2) : 0.0);
 }
 
-void Diode::updateState(const Eigen::VectorXd& solution, const std::map<std::string, int>& ci, const std::map<int, int>& nodeIdToMnaIndex) {
+void Diode::updateState(const Eigen::VectorXd& solution) {
     double v1 = 0.0, v2 = 0.0;
 
-    bool n1_is_ground = !nodeIdToMnaIndex.count(node1);
-    bool n2_is_ground = !nodeIdToMnaIndex.count(node2);
+    bool n1_is_ground = mna1 == -1;
+    bool n2_is_ground = mna2 == -1;
 
     if (!n1_is_ground) {
-        v1 = solution(nodeIdToMnaIndex.at(node1));
+        v1 = solution(mna1);
     }
     if (!n2_is_ground) {
-        v2 = solution(nodeIdToMnaIndex.at(node2));
+        v2 = solution(mna2);
     }
 
-    V_prev = v1 - v2;
+    double v = limitJunctionVoltage(v1 - v2, V_prev);
+    limited = v != v1 - v2;
+    V_prev = v;
+}
+
+// SPICE pnjlim: above Vcrit a Newton step of more than two thermal voltages is replaced by the step the
+// exponential would take, logarithmically compressed, so exp() neither overflows nor sends the next
+// iteration swinging back. Steps below Vcrit, and small ones, pass through unchanged.
+double Diode::limitJunctionVoltage(double vNew, double vOld) const {
+    const double nVt = eta * Vt;
+    if (vNew <= Vcrit || std::abs(vNew - vOld) <= 2 * nVt)
+        return vNew;
+    if (vOld > 0) {
+        double arg = 1 + (vNew - vOld) / nVt;
+        return arg > 0 ? vOld + nVt * std::log(arg) : Vcrit;
+    }
+    return nVt * std::log(vNew / nVt);
 }
 // -------------------------------- Update state implementation --------------------------------
 
 
 // -------------------------------- Reset initial values --------------------------------
 void Capacitor::reset() {
-    V_prev = 0.0;
+    V_prev = V_prev2 = I_prev = 0.0;
+    G_eq = I_eq = 0.0;
 }
 
 void Inductor::reset() {
-    I_prev = 0.0;
+    I_prev = I_prev2 = V_prev = 0.0;
 }
 
 void Diode::reset() {
-    V_prev = 0.0;
+    V_prev = V_INITIAL;
+    limited = false;
+    hasStamp = stampBypassed = false;
 }
 // -------------------------------- Reset initial values --------------------------------
 
 
 // -------------------------------- MNA Stamping Implementations --------------------------------
-void Resistor::stampMNA(Eigen::MatrixXd& A, Eigen::VectorXd& b, const std::map<std::string, int>& ci, const std::map<int, int>& nodeIdToMnaIndex, double time, double h, int idx) {
+// Coefficients of x' ~ a0 * x(n+1) + a1 * x(n) + a2 * x(n-1) for the linear multistep methods. Gear-2
+// uses the variable-step form and falls back to backward Euler until there is a previous step.
+static void derivativeCoefficients(const StepContext& step, double& a0, double& a1, double& a2) {
+    double h = step.h;
+    if (step.method == IntegrationMethod::GEAR2 && step.hPrev > 0.0) {
+        double r = h / step.hPrev;
+        a0 = (1.0 + 2.0 * r) / (h * (1.0 + r));
+        a1 = -(1.0 + r) / h;
+        a2 = r * r / (h * (1.0 + r));
+        return;
+    }
+    a0 = 1.0 / h;
+    a1 = -1.0 / h;
+    a2 = 0.0;
+}
+
+void Resistor::stampStatic(MNAMatrix& A) {
     double conductance = 1.0 / value;
 
-    bool n1_is_ground = !nodeIdToMnaIndex.count(node1);
-    bool n2_is_ground = !nodeIdToMnaIndex.count(node2);
+    bool n1_is_ground = mna1 == -1;
+    bool n2_is_ground = mna2 == -1;
 
     if (!n1_is_ground) {
-        A(nodeIdToMnaIndex.at(node1), nodeIdToMnaIndex.at(node1)) += conductance;
+        A.add(mna1, mna1, conductance);
     }
     if (!n2_is_ground) {
-        A(nodeIdToMnaIndex.at(node2), nodeIdToMnaIndex.at(node2)) += conductance;
+        A.add(mna2, mna2, conductance);
     }
     if (!n1_is_ground && !n2_is_ground) {
-        A(nodeIdToMnaIndex.at(node1), nodeIdToMnaIndex.at(node2)) -= conductance;
-        A(nodeIdToMnaIndex.at(node2), nodeIdToMnaIndex.at(node1)) -= conductance;
+        A.add(mna1, mna2, -conductance);
+        A.add(mna2, mna1, -conductance);
     }
 }
 
-void Capacitor::stampMNA(Eigen::MatrixXd& A, Eigen::VectorXd& b, const std::map<std::string, int>& ci, const std::map<int, int>& nodeIdToMnaIndex, double time, double h, int idx) {
+void Capacitor::stampTimeStep(MNAMatrix& A, Eigen::VectorXd& b, const StepContext& step) {
     // For DC analysis (h=0), a capacitor is an open circuit, so we do nothing.
-    if (h == 0.0)
+    if (step.h == 0.0) {
+        G_eq = I_eq = 0.0;
         return;
+    }
 
-    double G_eq = value / h;
-    double I_eq = G_eq * V_prev;
+    if (step.method == IntegrationMethod::TRAPEZOIDAL) {
+        G_eq = 2.0 * value / step.h;
+        I_eq = G_eq * V_prev + I_prev;
+    }
+    else {
+        double a0, a1, a2;
+        derivativeCoefficients(step, a0, a1, a2);
+        G_eq = value * a0;
+        I_eq = -value * (a1 * V_prev + a2 * V_prev2);
+    }
 
-    bool n1_is_ground = !nodeIdToMnaIndex.count(node1);
-    bool n2_is_ground = !nodeIdToMnaIndex.count(node2);
+    bool n1_is_ground = mna1 == -1;
+    bool n2_is_ground = mna2 == -1;
 
     if (!n1_is_ground) {
-        A(nodeIdToMnaIndex.at(node1), nodeIdToMnaIndex.at(node1)) += G_eq;
-        b(nodeIdToMnaIndex.at(node1)) += I_eq;
+        A.add(mna1, mna1, G_eq);
+        b(mna1) += I_eq;
     }
     if (!n2_is_ground) {
-        A(nodeIdToMnaIndex.at(node2), nodeIdToMnaIndex.at(node2)) += G_eq;
-        b(nodeIdToMnaIndex.at(node2)) -= I_eq;
+        A.add(mna2, mna2, G_eq);
+        b(mna2) -= I_eq;
     }
     if (!n1_is_ground && !n2_is_ground) {
-        A(nodeIdToMnaIndex.at(node1), nodeIdToMnaIndex.at(node2)) -= G_eq;
-        A(nodeIdToMnaIndex.at(node2), nodeIdToMnaIndex.at(node1)) -= G_eq;
+        A.add(mna1, mna2, -G_eq);
+        A.add(mna2, mna1, -G_eq);
     }
 }
 
-void Inductor::stampMNA(Eigen::MatrixXd& A, Eigen::VectorXd& b, const std::map<std::string, int>& ci, const std::map<int, int>& nodeIdToMnaIndex, double time, double h, int idx) {
-    if (idx == -1) {
+void Inductor::stampStatic(MNAMatrix& A) {
+    if (branch == -1) {
         std::cerr << "ERROR: Inductor '" << name << "' was not assigned a current index." << std::endl;
         return;
     }
 
-    bool n1_is_ground = !nodeIdToMnaIndex.count(node1);
-    bool n2_is_ground = !nodeIdToMnaIndex.count(node2);
+    bool n1_is_ground = mna1 == -1;
+    bool n2_is_ground = mna2 == -1;
 
     if (!n1_is_ground) {
-        A(nodeIdToMnaIndex.at(node1), idx) += 1.0;
-        A(idx, nodeIdToMnaIndex.at(node1)) += 1.0;
+        A.add(mna1, branch, 1.0);
+        A.add(branch, mna1, 1.0);
     }
     if (!n2_is_ground) {
-        A(nodeIdToMnaIndex.at(node2), idx) -= 1.0;
-        A(idx, nodeIdToMnaIndex.at(node2)) -= 1.0;
+        A.add(mna2, branch, -1.0);
+        A.add(branch, mna2, -1.0);
     }
+}
 
-    if (h != 0.0) {
-        A(idx, idx) -= value / h; // Change D matrix in A
-        b(idx) -= (value / h) * I_prev;  // Change the RHS matrix
+void Inductor::stampTimeStep(MNAMatrix& A, Eigen::VectorXd& b, const StepContext& step) {
+    if (branch == -1 || step.h == 0.0)
+        return;
+
+    if (step.method == IntegrationMethod::TRAPEZOIDAL) {
+        double R_eq = 2.0 * value / step.h;
+        A.add(branch, branch, -R_eq);
+        b(branch) -= R_eq * I_prev + V_prev;
+        return;
     }
+
+    double a0, a1, a2;
+    derivativeCoefficients(step, a0, a1, a2);
+    A.add(branch, branch, -value * a0); // Change D matrix in A
+    b(branch) += value * (a1 * I_prev + a2 * I_prev2);  // Change the RHS matrix
 }
 
-void Diode::stampMNA(Eigen::MatrixXd& A, Eigen::VectorXd& b, const std::map<std::string, int>& ci, const std::map<int, int>& nodeIdToMnaIndex, double time, double h, int idx) {
-    const double Gmin = 1e-12;
+void Diode::stampIteration(MNAMatrix& A, Eigen::VectorXd& b, const StepContext& step) {
+    double dv = V_prev - V_lin;
+    double di = G_lin * dv;
+    stampBypassed = hasStamp &&
+                    std::abs(dv) <= step.bypassReltol * std::max(std::abs(V_prev), std::abs(V_lin)) + step.bypassVntol &&
+                    std::abs(di) <= step.bypassReltol * std::max(std::abs(I_lin + di), std::abs(I_lin)) + step.bypassAbstol;
+    if (!stampBypassed) {
+        V_lin = V_prev;
+        I_lin = Is * (exp(V_lin / (eta * Vt)) - 1.0);
+        G_lin = (Is / (eta * Vt)) * exp(V_lin / (eta * Vt)) + GMIN;
+        hasStamp = true;
+    }
 
-    const double I = Is * (exp(V_prev / (eta * Vt)) - 1.0);
-    const double Gd = (Is / (eta * Vt)) * exp(V_prev / (eta * Vt)) + Gmin;
-    const double Ieq = I - Gd * V_prev;
+    const double Gd = G_lin;
+    const double Ieq = I_lin - G_lin * V_lin;
 
-    bool n1_is_ground = !nodeIdToMnaIndex.count(node1);
-    bool n2_is_ground = !nodeIdToMnaIndex.count(node2);
+    bool n1_is_ground = mna1 == -1;
+    bool n2_is_ground = mna2 == -1;
 
     if (!n1_is_ground)
-        A(nodeIdToMnaIndex.at(node1), nodeIdToMnaIndex.at(node1)) += Gd;
+        A.add(mna1, mna1, Gd);
     if (!n2_is_ground)
-        A(nodeIdToMnaIndex.at(node2), nodeIdToMnaIndex.at(node2)) += Gd;
+        A.add(mna2, mna2, Gd);
     if (!n1_is_ground && !n2_is_ground) {
-        A(nodeIdToMnaIndex.at(node1), nodeIdToMnaIndex.at(node2)) -= Gd;
-        A(nodeIdToMnaIndex.at(node2), nodeIdToMnaIndex.at(node1)) -= Gd;
+        A.add(mna1, mna2, -Gd);
+        A.add(mna2, mna1, -Gd);
     }
 
-    if (!n1_is_ground != -1) {
-        b(nodeIdToMnaIndex.at(node1)) -= Ieq;
+    if (!n1_is_ground) {
+        b(mna1) -= Ieq;
     }
     if (!n2_is_ground) {
-        b(nodeIdToMnaIndex.at(node2)) += Ieq;
+        b(mna2) += Ieq;
     }
 }
 
-void VoltageSource::stampMNA(Eigen::MatrixXd& A, Eigen::VectorXd& b, const std::map<std::string, int>& ci,const std::map<int, int>& nodeIdToMnaIndex, double time, double h, int idx) {
-    if (idx == -1) {
+void VoltageSource::stampStatic(MNAMatrix& A) {
+    if (branch == -1) {
         std::cerr << "ERROR: VoltageSource '" << name << "' was not assigned a current index." << std::endl;
         return;
     }
 
-    bool n1_is_ground = !nodeIdToMnaIndex.count(node1);
-    bool n2_is_ground = !nodeIdToMnaIndex.count(node2);
+    bool n1_is_ground = mna1 == -1;
+    bool n2_is_ground = mna2 == -1;
 
     if (!n1_is_ground) {
-        A(nodeIdToMnaIndex.at(node1), idx) += 1.0;
+        A.add(mna1, branch, 1.0);
     }
     if (!n2_is_ground) {
-        A(nodeIdToMnaIndex.at(node2), idx) -= 1.0;
+        A.add(mna2, branch, -1.0);
     }
     if (!n1_is_ground) {
-        A(idx, nodeIdToMnaIndex.at(node1)) += 1.0;
+        A.add(branch, mna1, 1.0);
     }
     if (!n2_is_ground) {
-        A(idx, nodeIdToMnaIndex.at(node2)) -= 1.0;
+        A.add(branch, mna2, -1.0);
     }
+}
+
+void VoltageSource::stampTimeStep(MNAMatrix& /*A*/, Eigen::VectorXd& b, const StepContext& step) {
+    if (branch == -1)
+        return;
 
-    b(idx) += waveForm->getValue(time);
+    b(branch) += waveForm->getValue(step.time);
 }
 
-void CurrentSource::stampMNA(Eigen::MatrixXd& A, Eigen::VectorXd& b, const std::map<std::string, int>& ci, const std::map<int, int>& nodeIdToMnaIndex,double time, double h, int idx) {
-    double currentValue = waveForm->getValue(time);
+void CurrentSource::stampTimeStep(MNAMatrix& /*A*/, Eigen::VectorXd& b, const StepContext& step) {
+    double currentValue = waveForm->getValue(step.time);
 
-    bool n1_is_ground = !nodeIdToMnaIndex.count(node1);
-    bool n2_is_ground = !nodeIdToMnaIndex.count(node2);
+    bool n1_is_ground = mna1 == -1;
+    bool n2_is_ground = mna2 == -1;
 
     if (!n1_is_ground) {
-        b(nodeIdToMnaIndex.at(node1)) -= currentValue;
+        b(mna1) -= currentValue;
     }
     if (!n2_is_ground) {
-        b(nodeIdToMnaIndex.at(node2)) += currentValue;
+        b(mna2) += currentValue;
     }
 }
 
-void VCVS::stampMNA(Eigen::MatrixXd& A, Eigen::VectorXd& b, const std::map<std::string, int>& ci, const std::map<int, int>& nodeIdToMnaIndex,double time, double h, int idx) {
-    if (idx == -1) {
+void VCVS::stampStatic(MNAMatrix& A) {
+    if (branch == -1) {
         std::cerr << "ERROR: VCVS '" << name << "' was not assigned a current index." << std::endl;
         return;
     }
 
-    bool n1_is_ground = !nodeIdToMnaIndex.count(node1);
-    bool n2_is_ground = !nodeIdToMnaIndex.count(node2);
+    bool n1_is_ground = mna1 == -1;
+    bool n2_is_ground = mna2 == -1;
 
     if (!n1_is_ground) {
-        A(nodeIdToMnaIndex.at(node1), idx) += 1.0;
-        A(idx, nodeIdToMnaIndex.at(node1)) += 1.0;
+        A.add(mna1, branch, 1.0);
+        A.add(branch, mna1, 1.0);
     }
     if (!n2_is_ground) {
-        A(nodeIdToMnaIndex.at(node2), idx) -= 1.0;
-        A(idx, nodeIdToMnaIndex.at(node2)) -= 1.0;
+        A.add(mna2, branch, -1.0);
+        A.add(branch, mna2, -1.0);
     }
 
-    if (nodeIdToMnaIndex.count(ctrlNode1)) {
-        A(idx, nodeIdToMnaIndex.at(ctrlNode1)) -= gain;
+    if (ctrlMna1 != -1) {
+        A.add(branch, ctrlMna1, -gain);
     }
-    if (nodeIdToMnaIndex.count(ctrlNode2)) {
-        A(idx, nodeIdToMnaIndex.at(ctrlNode1)) += gain;
+    if (ctrlMna2 != -1) {
+        A.add(branch, ctrlMna2, gain);
     }
 }
 
-void VCCS::stampMNA(Eigen::MatrixXd& A, Eigen::VectorXd& b, const std::map<std::string, int>& ci, const std::map<int, int>& nodeIdToMnaIndex,double time, double h, int idx) {
-    bool n1_is_ground = !nodeIdToMnaIndex.count(node1);
-    bool n2_is_ground = !nodeIdToMnaIndex.count(node2);
-    bool ctrlNode1_is_ground = !nodeIdToMnaIndex.count(ctrlNode1);
-    bool ctrlNode2_is_ground = !nodeIdToMnaIndex.count(ctrlNode2);
+void VCCS::stampStatic(MNAMatrix& A) {
+    bool n1_is_ground = mna1 == -1;
+    bool n2_is_ground = mna2 == -1;
+    bool ctrlNode1_is_ground = ctrlMna1 == -1;
+    bool ctrlNode2_is_ground = ctrlMna2 == -1;
 
     if (!n1_is_ground && !ctrlNode1_is_ground) {
-        A(nodeIdToMnaIndex.at(node1), nodeIdToMnaIndex.at(ctrlNode1)) += gain;
+        A.add(mna1, ctrlMna1, gain);
     }
     if (!n1_is_ground && !ctrlNode2_is_ground) {
-        A(nodeIdToMnaIndex.at(node1), nodeIdToMnaIndex.at(ctrlNode2)) -= gain;
+        A.add(mna1, ctrlMna2, -gain);
     }
     if (!n2_is_ground && !ctrlNode1_is_ground) {
-        A(nodeIdToMnaIndex.at(node2), nodeIdToMnaIndex.at(ctrlNode1)) -= gain;
+        A.add(mna2, ctrlMna1, -gain);
     }
     if (!n2_is_ground && !ctrlNode2_is_ground) {
-        A(nodeIdToMnaIndex.at(node2), nodeIdToMnaIndex.at(ctrlNode2)) += gain;
+        A.add(mna2, ctrlMna2, gain);
     }
 }
 
-void CCVS::stampMNA(Eigen::MatrixXd& A, Eigen::VectorXd& b, const std::map<std::string, int>& ci,const std::map<int, int>& nodeIdToMnaIndex, double time, double h, int idx) {
-    if (idx == -1) {
+void CCVS::stampStatic(MNAMatrix& A) {
+    if (branch == -1) {
         std::cerr << "ERROR: CCVS '" << name << "' was not assigned a current index." << std::endl;
         return;
     }
 
-    auto it = ci.find(ctrlCompName);
-    if (it == ci.end()) {
-        std::cerr << "ERROR: Controlling component '" << ctrlCompName << "' for CCVS '" << name << "' not found or has no current." << std::endl;
+    if (ctrlBranch == -1)
         return;
-    }
-    int ctrl_idx = it->second;
 
-    bool n1_is_ground = !nodeIdToMnaIndex.count(node1);
-    bool n2_is_ground = !nodeIdToMnaIndex.count(node2);
+    bool n1_is_ground = mna1 == -1;
+    bool n2_is_ground = mna2 == -1;
 
      if (!n1_is_ground) {
-        A(nodeIdToMnaIndex.at(node1), idx) += 1.0;
-        A(idx, nodeIdToMnaIndex.at(node1)) += 1.0;
+        A.add(mna1, branch, 1.0);
+        A.add(branch, mna1, 1.0);
     }
     if (!n2_is_ground) {
-        A(nodeIdToMnaIndex.at(node2), idx) -= 1.0;
-        A(idx, nodeIdToMnaIndex.at(node2)) -= 1.0;
+        A.add(mna2, branch, -1.0);
+        A.add(branch, mna2, -1.0);
     }
 
-    A(idx, ctrl_idx) -= gain;
+    A.add(branch, ctrlBranch, -gain);
 }
 
-void CCCS::stampMNA(Eigen::MatrixXd& A, Eigen::VectorXd& b, const std::map<std::string, int>& ci,const std::map<int, int>& nodeIdToMnaIndex, double time, double h, int idx) {
-    auto it = ci.find(ctrlCompName);
-    if (it == ci.end()) {
-        std::cerr << "ERROR: Controlling component '" << ctrlCompName << "' for CCCS '" << name << "' not found or has no current." << std::endl;
+void CCCS::stampStatic(MNAMatrix& A) {
+    if (ctrlBranch == -1)
         return;
-    }
-    int ctrl_idx = it->second;
 
-    bool n1_is_ground = !nodeIdToMnaIndex.count(node1);
-    bool n2_is_ground = !nodeIdToMnaIndex.count(node2);
+    bool n1_is_ground = mna1 == -1;
+    bool n2_is_ground = mna2 == -1;
 
     if (!n1_is_ground)
-        A(nodeIdToMnaIndex.at(node1), ctrl_idx) += gain;
+        A.add(mna1, ctrlBranch, gain);
     if (!n2_is_ground)
-        A(nodeIdToMnaIndex.at(node2), ctrl_idx) -= gain;
+        A.add(mna2, ctrlBranch, -gain);
 }
 // -------------------------------- MNA Stamping Implementations --------------------------------
 
 
 // -------------------------------- Set Values for DC Sweep --------------------------------
-void VoltageSource::setValue(double v) {
-    if (auto i = dynamic_cast<DCWaveform*>(waveForm.get()))
+bool VoltageSource::setValue(double v) {
+    if (auto i = dynamic_cast<DCWaveform*>(waveForm.get())) {
         i->setValue(v);
-    else
-        std::cout << "Cannot perform DC Sweep on non-dc source: " << name << std::endl;
+        return true;
+    }
+    return false;
 }
 
-void CurrentSource::setValue(double v) {
-    if (auto i = dynamic_cast<DCWaveform*>(waveForm.get()))
+bool CurrentSource::setValue(double v) {
+    if (auto i = dynamic_cast<DCWaveform*>(waveForm.get())) {
         i->setValue(v);
-    else
-        std::cout << "Cannot perform DC Sweep on non-dc source: " << name << std::endl;
+        return true;
+    }
+    return false;
+}
+// -------------------------------- Set Values for DC Sweep --------------------------------
+
+
+// -------------------------------- Newton Convergence --------------------------------
+bool Diode::currentConverged(const Eigen::VectorXd& solution, double reltol, double abstol) const {
+    // A limited step was not the Newton step, so the iterate it produced cannot be the answer yet
+    if (limited)
+        return false;
+
+    double v = (mna1 == -1 ? 0.0 : solution(mna1)) - (mna2 == -1 ? 0.0 : solution(mna2));
+
+    // The model stamped for this iteration is the tangent at V_lin (V_prev unless it was bypassed)
+    double linearCurrent = I_lin + (G_lin - GMIN) * (v - V_lin);
+    double deviceCurrent = Is * (exp(v / (eta * Vt)) - 1.0);
+
+    return std::abs(deviceCurrent - linearCurrent) <= reltol * std::max(std::abs(deviceCurrent), std::abs(linearCurrent)) + abstol;
 }
-// -------------------------------- Set Values for DC Sweep --------------------------------
\ No newline at end of file
+// -------------------------------- Newton Convergence --------------------------------
@@ -2,14 +2,39 @@
 #define COMPONENT_H
 
 #include <Eigen/Dense>
+#include "MNAMatrix.h"
+#include "StringInterner.h"
 #include "WaveForm.h"
 #include <string>
 #include <iostream>
 #include <memory>
 #include <map>
+#include <vector>
+#include <limits>
 
 class Circuit;
 
+enum class IntegrationMethod {
+    BACKWARD_EULER,
+    TRAPEZOIDAL,
+    GEAR2
+};
+
+// What the time-step stamps need to know about the point being solved. h is 0 for DC, hPrev is the
+// previous accepted step (0 when there is no history yet).
+struct StepContext {
+    double time = 0.0;
+    double h = 0.0;
+    double hPrev = 0.0;
+    IntegrationMethod method = IntegrationMethod::BACKWARD_EULER;
+    // Device bypass: a nonlinear device whose voltage moved by no more than bypassReltol * |v| + bypassVntol
+    // since its last evaluation, with the current change that implies within bypassReltol * |i| + bypassAbstol,
+    // keeps that evaluation's stamp. All 0 means only an unchanged device is bypassed.
+    double bypassReltol = 0.0;
+    double bypassVntol = 0.0;
+    double bypassAbstol = 0.0;
+};
+
 // -------------------------------- Component Class and Its Implementations --------------------------------
 class Component {
 public:
@@ -28,15 +53,39 @@ public:
     int node2;
     double value;
 
+    // MNA rows resolved by compileStamps() once per topology, -1 for ground or when not assigned
+    int mna1 = -1;
+    int mna2 = -1;
+    int branch = -1;
+
     Component(Type t, const std::string& n, int n1, int n2, double v) : type(t), name(std::move(n)), node1(n1), node2(n2), value(v) {}
 
     virtual ~Component() {}
+    // Deep copy, used to snapshot a circuit for a simulation running on another thread
+    virtual Component* clone() const = 0;
     virtual void reset() {}
-    virtual void stampMNA(Eigen::MatrixXd& A, Eigen::VectorXd& b, const std::map<std::string, int> &ci,
-        const std::map<int, int>& nodeIdToMnaIndex, double time, double h, int idx) = 0;
-    virtual void updateState(const Eigen::VectorXd& solution, const std::map<std::string, int>& ci, const std::map<int, int>& nodeIdToMnaIndex) {}
+    // Stamps are split by how often their contribution changes, so Circuit can cache the constant part:
+    //   stampStatic    - matrix entries fixed for a given topology (conductances, incidence, gains)
+    //   stampTimeStep  - entries that depend on the time point or step size (source values, companion models)
+    //   stampIteration - entries that move on every Newton iteration (nonlinear devices)
+    virtual void compileStamps(const std::vector<int>& nodeMnaRow, const StringInterner& componentNames,
+                               const std::vector<int>& branchRows, int idx);
+    virtual void stampStatic(MNAMatrix& /*A*/) {}
+    virtual void stampTimeStep(MNAMatrix& /*A*/, Eigen::VectorXd& /*b*/, const StepContext& /*step*/) {}
+    virtual void stampIteration(MNAMatrix& /*A*/, Eigen::VectorXd& /*b*/, const StepContext& /*step*/) {}
+    virtual void updateState(const Eigen::VectorXd& /*solution*/) {}
     virtual bool isNonlinear() const { return false; }
+    // Newton check of a nonlinear device: does the current of its linearized model at `solution` match the
+    // real device current within reltol * |I| + abstol? Called before updateState() moves the operating point.
+    virtual bool currentConverged(const Eigen::VectorXd& /*solution*/, double /*reltol*/, double /*abstol*/) const {
+        return true;
+    }
+    // True when the last stampIteration() reused the previous stamp (device bypass)
+    virtual bool bypassed() const { return false; }
     virtual bool needsCurrentUnknown() const { return false; }
+    // Forwarded from the source waveforms, see IWaveformStrategy
+    virtual void getBreakpoints(double /*from*/, double /*to*/, std::vector<Breakpoint>& /*out*/) const {}
+    virtual double getMaxStep(double /*time*/) const { return std::numeric_limits<double>::infinity(); }
 
     std::string getName() const {
         return name;
@@ -47,30 +96,42 @@ public:
 class Resistor : public Component {
 public:
     Resistor(const std::string& n, int n1, int n2, double v);
-    void stampMNA(Eigen::MatrixXd&, Eigen::VectorXd&, const std::map<std::string, int> &,const std::map<int, int>& nodeIdToMnaIndex,  double, double, int) override;
+    Resistor* clone() const override { return new Resistor(*this); }
+    void stampStatic(MNAMatrix&) override;
 };
 
 
 class Capacitor : public Component {
 private:
     double V_prev;
+    double V_prev2;
+    double I_prev;
+    double G_eq;    // companion model of the last stamp, i = G_eq * v - I_eq
+    double I_eq;
 public:
     Capacitor(const std::string& n, int n1, int n2, double v);
-    void updateState(const Eigen::VectorXd& solution, const std::map<std::string, int>& ci, const std::map<int, int>& nodeIdToMnaIndex) override;
+    Capacitor* clone() const override { return new Capacitor(*this); }
+    // Current at the last accepted point, from the companion model of the integration method in use
+    double getCurrent() const { return I_prev; }
+    void updateState(const Eigen::VectorXd& solution) override;
     void reset() override;
-    void stampMNA(Eigen::MatrixXd&, Eigen::VectorXd&, const std::map<std::string, int> &, const std::map<int, int>& nodeIdToMnaIndex, double, double, int) override;
+    void stampTimeStep(MNAMatrix&, Eigen::VectorXd&, const StepContext&) override;
 };
 
 
 class Inductor : public Component {
 private:
     double I_prev;
+    double I_prev2;
+    double V_prev;
 public:
     Inductor(const std::string& n, int n1, int n2, double v);
+    Inductor* clone() const override { return new Inductor(*this); }
     bool needsCurrentUnknown() const override { return true; }
-    void updateState(const Eigen::VectorXd& solution, const std::map<std::string, int>& ci, const std::map<int, int>& nodeIdToMnaIndex) override;
+    void updateState(const Eigen::VectorXd& solution) override;
     void reset() override;
-    void stampMNA(Eigen::MatrixXd&, Eigen::VectorXd&, const std::map<std::string, int> &,const std::map<int, int>& nodeIdToMnaIndex,  double, double, int) override;
+    void stampStatic(MNAMatrix&) override;
+    void stampTimeStep(MNAMatrix&, Eigen::VectorXd&, const StepContext&) override;
 };
 
 
@@ -80,11 +141,23 @@ private:
     double Vt;
     double eta;
     double V_prev;
+    double Vcrit;   // where exp() turns steep enough for Newton to overshoot, see limitJunctionVoltage
+    bool limited;   // the last updateState() had to limit the Newton step
+    // Operating point of the last evaluated stamp: voltage, current and conductance (including GMIN)
+    bool hasStamp;
+    bool stampBypassed;
+    double V_lin, I_lin, G_lin;
+    static constexpr double GMIN = 1e-12;
+    static constexpr double V_INITIAL = 0.0; // first Newton guess of the junction voltage, fresh or reset
+    double limitJunctionVoltage(double vNew, double vOld) const;
 public:
     Diode(const std::string& n, int n1, int n2, double Is = 1e-12, double eta = 1.0, double Vt = 0.026);
+    Diode* clone() const override { return new Diode(*this); }
     bool isNonlinear() const override { return true; }
-    void updateState(const Eigen::VectorXd& solution, const std::map<std::string, int>& ci, const std::map<int, int>& nodeIdToMnaIndex) override;
-    void stampMNA(Eigen::MatrixXd&, Eigen::VectorXd&, const std::map<std::string, int> &, const std::map<int, int>& nodeIdToMnaIndex, double, double, int) override;
+    void updateState(const Eigen::VectorXd& solution) override;
+    void stampIteration(MNAMatrix&, Eigen::VectorXd&, const StepContext&) override;
+    bool currentConverged(const Eigen::VectorXd& solution, double reltol, double abstol) const override;
+    bool bypassed() const override { return stampBypassed; }
     void setPreviousVoltage(double v) { V_prev = v; }
     void reset() override;
 };
@@ -95,9 +168,14 @@ private:
     std::unique_ptr<IWaveformStrategy> waveForm;
 public:
     VoltageSource(const std::string& name, int node1, int node2, std::unique_ptr<IWaveformStrategy> wf);
+    VoltageSource(const VoltageSource& other);
+    VoltageSource* clone() const override { return new VoltageSource(*this); }
     bool needsCurrentUnknown() const override { return true; }
-    void stampMNA(Eigen::MatrixXd&, Eigen::VectorXd&, const std::map<std::string, int> &, const std::map<int, int>& nodeIdToMnaIndex, double, double, int) override;
-    void setValue(double v);
+    void getBreakpoints(double from, double to, std::vector<Breakpoint>& out) const override { waveForm->getBreakpoints(from, to, out); }
+    double getMaxStep(double time) const override { return waveForm->getMaxStep(time); }
+    void stampStatic(MNAMatrix&) override;
+    void stampTimeStep(MNAMatrix&, Eigen::VectorXd&, const StepContext&) override;
+    bool setValue(double v);
 };
 
 
@@ -106,8 +184,12 @@ private:
     std::unique_ptr<IWaveformStrategy> waveForm;
 public:
     CurrentSource(const std::string& n, int n1, int n2, std::unique_ptr<IWaveformStrategy> wf);
-    void stampMNA(Eigen::MatrixXd&, Eigen::VectorXd&, const std::map<std::string, int> &, const std::map<int, int>& nodeIdToMnaIndex, double, double, int) override;
-    void setValue(double v);
+    CurrentSource(const CurrentSource& other);
+    CurrentSource* clone() const override { return new CurrentSource(*this); }
+    void getBreakpoints(double from, double to, std::vector<Breakpoint>& out) const override { waveForm->getBreakpoints(from, to, out); }
+    double getMaxStep(double time) const override { return waveForm->getMaxStep(time); }
+    void stampTimeStep(MNAMatrix&, Eigen::VectorXd&, const StepContext&) override;
+    bool setValue(double v);
 };
 
 
@@ -115,11 +197,15 @@ public:
 class VCVS : public Component {
 private:
     int ctrlNode1, ctrlNode2;
+    int ctrlMna1 = -1, ctrlMna2 = -1;
     double gain;
 public:
     VCVS(const std::string& n, int n1, int n2, int ctrlN1, int ctrlN2, double gain);
+    VCVS* clone() const override { return new VCVS(*this); }
     bool needsCurrentUnknown() const override { return true; }
-    void stampMNA(Eigen::MatrixXd&, Eigen::VectorXd&, const std::map<std::string, int> &, const std::map<int, int>& nodeIdToMnaIndex, double, double, int) override;
+    void compileStamps(const std::vector<int>& nodeMnaRow, const StringInterner& componentNames,
+                       const std::vector<int>& branchRows, int idx) override;
+    void stampStatic(MNAMatrix&) override;
 };
 
 
@@ -127,10 +213,14 @@ public:
 class VCCS : public Component {
 private:
     int ctrlNode1, ctrlNode2;
+    int ctrlMna1 = -1, ctrlMna2 = -1;
     double gain;
 public:
     VCCS(const std::string& n, int n1, int n2, int ctrlN1, int ctrlN2, double gain);
-    void stampMNA(Eigen::MatrixXd&, Eigen::VectorXd&, const std::map<std::string, int>&, const std::map<int, int>& nodeIdToMnaIndex, double, double , int) override;
+    VCCS* clone() const override { return new VCCS(*this); }
+    void compileStamps(const std::vector<int>& nodeMnaRow, const StringInterner& componentNames,
+                       const std::vector<int>& branchRows, int idx) override;
+    void stampStatic(MNAMatrix&) override;
 };
 
 
@@ -140,10 +230,14 @@ private:
     std::string ctrlCompName;
     double gain;
     int sourceIndex;
+    int ctrlBranch = -1;
 public:
     CCVS(const std::string& n, int n1, int n2, const std::string& ctrlComp, double gain);
+    CCVS* clone() const override { return new CCVS(*this); }
     bool needsCurrentUnknown() const override { return true; }
-    void stampMNA(Eigen::MatrixXd&, Eigen::VectorXd&, const std::map<std::string, int> &, const std::map<int, int>& nodeIdToMnaIndex, double, double, int) override;
+    void compileStamps(const std::vector<int>& nodeMnaRow, const StringInterner& componentNames,
+                       const std::vector<int>& branchRows, int idx) override;
+    void stampStatic(MNAMatrix&) override;
 };
 
 
@@ -152,9 +246,13 @@ class CCCS : public Component {
 private:
     std::string ctrlCompName;
     double gain;
+    int ctrlBranch = -1;
 public:
     CCCS(const std::string& n, int n1, int n2, const std::string& ctrlComp, double gain);
-    void stampMNA(Eigen::MatrixXd&, Eigen::VectorXd&, const std::map<std::string, int> &, const std::map<int, int>& nodeIdToMnaIndex, double, double, int) override;
+    CCCS* clone() const override { return new CCCS(*this); }
+    void compileStamps(const std::vector<int>& nodeMnaRow, const StringInterner& componentNames,
+                       const std::vector<int>& branchRows, int idx) override;
+    void stampStatic(MNAMatrix&) override;
 };
 // -------------------------------- Component Class and Its Implementations --------------------------------
 
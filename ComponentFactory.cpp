@@ -4,6 +4,18 @@
 
 #include "ComponentFactory.h"
 
+// Source waveform from the parsed parameters, stringParams[0] names PULSE or PWL functions
+static std::unique_ptr<IWaveformStrategy> createWaveform(double value, const std::vector<double>& numericParams,
+                                                         const std::vector<std::string>& stringParams, bool isSinusoidal) {
+    if (isSinusoidal)
+        return std::make_unique<SinusoidalWaveform>(numericParams[0], numericParams[1], numericParams[2]);
+    if (!stringParams.empty() && stringParams[0] == "PULSE")
+        return std::make_unique<PulseWaveform>(numericParams);
+    if (!stringParams.empty() && stringParams[0] == "PWL")
+        return std::make_unique<PwlWaveform>(numericParams);
+    return std::make_unique<DCWaveform>(value);
+}
+
 Component* ComponentFactory::createComponent(
         const std::string& typeStr,
         const std::string& name,
@@ -32,22 +44,12 @@ Component* ComponentFactory::createComponent(
             throw std::runtime_error("Inductance cannot be zero or negative");
         newComp = new Inductor(name, n1_id, n2_id, value);
     }
-    else if (typeStr == "V") {
-        std::unique_ptr<IWaveformStrategy> wf;
-        if (isSinusoidal)
-             wf = std::make_unique<SinusoidalWaveform>(numericParams[0], numericParams[1], numericParams[2]);
-        else
-             wf = std::make_unique<DCWaveform>(value);
-        newComp = new VoltageSource(name, n1_id, n2_id, std::move(wf));
-    }
-    else if (typeStr == "I") {
-        std::unique_ptr<IWaveformStrategy> wf;
-        if (isSinusoidal)
-            wf = std::make_unique<SinusoidalWaveform>(numericParams[0], numericParams[1], numericParams[2]);
-        else
-            wf = std::make_unique<DCWaveform>(value);
-        newComp = new CurrentSource(name, n1_id, n2_id, std::move(wf));
-    }
+    else if (typeStr == "V")
+        newComp = new VoltageSource(name, n1_id, n2_id, createWaveform(value, numericParams, stringParams, isSinusoidal));
+
+    else if (typeStr == "I")
+        newComp = new CurrentSource(name, n1_id, n2_id, createWaveform(value, numericParams, stringParams, isSinusoidal));
+
     else if (typeStr == "D")
         newComp = new Diode(name, n1_id, n2_id, 1e-12, 1.0, 0.026);
 
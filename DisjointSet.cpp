@@ -0,0 +1,49 @@
+#include "DisjointSet.h"
+#include <utility>
+
+// -------------------------------- Constructor impementation --------------------------------
+DisjointSet::DisjointSet(int size) {
+    grow(size);
+}
+// -------------------------------- Constructor impementation --------------------------------
+
+
+// -------------------------------- Find and Unite --------------------------------
+void DisjointSet::grow(int size) {
+    for (int i = static_cast<int>(parent.size()); i < size; ++i) {
+        parent.push_back(i);
+        rank.push_back(0);
+    }
+}
+
+int DisjointSet::find(int x) {
+    int root = x;
+    while (parent[root] != root)
+        root = parent[root];
+    while (parent[x] != root) {
+        int next = parent[x];
+        parent[x] = root;
+        x = next;
+    }
+    return root;
+}
+
+int DisjointSet::find(int x) const {
+    while (parent[x] != x)
+        x = parent[x];
+    return x;
+}
+
+bool DisjointSet::unite(int a, int b) {
+    a = find(a);
+    b = find(b);
+    if (a == b)
+        return false;
+    if (rank[a] < rank[b])
+        std::swap(a, b);
+    parent[b] = a;
+    if (rank[a] == rank[b])
+        rank[a]++;
+    return true;
+}
+// -------------------------------- Find and Unite --------------------------------
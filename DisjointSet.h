@@ -0,0 +1,28 @@
+#ifndef DISJOINTSET_H
+#define DISJOINTSET_H
+
+#include <vector>
+
+// -------------------------------- Union-Find over Node Ids --------------------------------
+// Elements are the integers 0..size()-1. find() compresses the path it walks and unite() links by rank,
+// so any sequence of operations runs in near-linear time. The const find() leaves the paths as they are,
+// which union by rank keeps at O(log n).
+class DisjointSet {
+public:
+    explicit DisjointSet(int size = 0);
+
+    // Adds singleton sets up to the new size
+    void grow(int size);
+    int size() const { return static_cast<int>(parent.size()); }
+    int find(int x);
+    int find(int x) const;
+    // Returns false when a and b already were in the same set
+    bool unite(int a, int b);
+
+private:
+    std::vector<int> parent;
+    std::vector<unsigned char> rank;
+};
+// -------------------------------- Union-Find over Node Ids --------------------------------
+
+#endif //DISJOINTSET_H
@@ -0,0 +1,79 @@
+#include "MNAMatrix.h"
+
+// -------------------------------- Constructor impementation --------------------------------
+MNAMatrix::MNAMatrix(Backend b) : backend(b), n(0), frozen(false), tripletLayers{0, 0} {}
+// -------------------------------- Constructor impementation --------------------------------
+
+
+// -------------------------------- Size and Backend --------------------------------
+void MNAMatrix::setBackend(Backend b) {
+    if (backend == b)
+        return;
+    backend = b;
+    denseMatrix.resize(0, 0);
+    denseLayers[0].resize(0, 0);
+    denseLayers[1].resize(0, 0);
+    sparseMatrix.resize(0, 0);
+    triplets.clear();
+    resize(n);
+}
+
+void MNAMatrix::resize(int size) {
+    n = size;
+    if (backend == Backend::DENSE) {
+        if (denseMatrix.rows() != n)
+            denseMatrix.resize(n, n);
+    }
+    else if (sparseMatrix.rows() != n)
+        sparseMatrix.resize(n, n);
+    setZero();
+}
+
+void MNAMatrix::setZero() {
+    if (backend == Backend::DENSE)
+        denseMatrix.setZero();
+    else
+        triplets.clear();
+}
+// -------------------------------- Size and Backend --------------------------------
+
+
+// -------------------------------- Stamping --------------------------------
+void MNAMatrix::add(int row, int col, double value) {
+    if (frozen)
+        return;
+    if (backend == Backend::DENSE)
+        denseMatrix(row, col) += value;
+    else
+        triplets.emplace_back(row, col, value);
+}
+
+void MNAMatrix::finalize() {
+    // Duplicate (row, col) entries from different components are summed by setFromTriplets.
+    if (backend == Backend::SPARSE && !frozen)
+        sparseMatrix.setFromTriplets(triplets.begin(), triplets.end());
+}
+
+// Triplets are only ever appended, so a sparse layer is just a prefix of the triplet list.
+void MNAMatrix::saveLayer(Layer layer) {
+    int l = static_cast<int>(layer);
+    if (backend == Backend::DENSE)
+        denseLayers[l] = denseMatrix;
+    else
+        tripletLayers[l] = triplets.size();
+}
+
+void MNAMatrix::restoreLayer(Layer layer) {
+    int l = static_cast<int>(layer);
+    if (backend == Backend::DENSE)
+        denseMatrix = denseLayers[l];
+    else
+        triplets.resize(tripletLayers[l]);
+}
+
+Eigen::VectorXd MNAMatrix::multiply(const Eigen::VectorXd& x) const {
+    if (backend == Backend::DENSE)
+        return denseMatrix * x;
+    return sparseMatrix * x;
+}
+// -------------------------------- Stamping --------------------------------
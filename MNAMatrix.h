@@ -0,0 +1,64 @@
+#ifndef MNAMATRIX_H
+#define MNAMATRIX_H
+
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+#include <vector>
+
+// -------------------------------- MNA Matrix with Dense and Sparse Backends --------------------------------
+// Components stamp into this through add(row, col, value). The dense backend writes straight into an
+// Eigen::MatrixXd, the sparse backend collects triplets and compresses them in finalize().
+class MNAMatrix {
+public:
+    enum class Backend {
+        DENSE,
+        SPARSE
+    };
+
+    // Saved stages of the assembly. STATIC holds the topology-constant stamps, TIME_STEP adds the
+    // stamps of the current time point on top of it, so Circuit only has to re-add what changed.
+    enum class Layer {
+        STATIC,
+        TIME_STEP
+    };
+
+    explicit MNAMatrix(Backend b = Backend::SPARSE);
+
+    void setBackend(Backend b);
+    Backend getBackend() const { return backend; }
+
+    void resize(int n);
+    void setZero();
+    int size() const { return n; }
+
+    void add(int row, int col, double value);
+    void finalize();
+
+    // While frozen, add() and finalize() leave the assembled matrix untouched (RHS-only restamps).
+    void setFrozen(bool f) { frozen = f; }
+    bool isFrozen() const { return frozen; }
+
+    void saveLayer(Layer layer);
+    void restoreLayer(Layer layer);
+
+    // A * x with the assembled matrix
+    Eigen::VectorXd multiply(const Eigen::VectorXd& x) const;
+
+    const Eigen::MatrixXd& dense() const { return denseMatrix; }
+    const Eigen::SparseMatrix<double>& sparse() const { return sparseMatrix; }
+
+private:
+    Backend backend;
+    int n;
+    bool frozen;
+
+    Eigen::MatrixXd denseMatrix;
+    std::vector<Eigen::Triplet<double>> triplets;
+    Eigen::SparseMatrix<double> sparseMatrix;
+
+    Eigen::MatrixXd denseLayers[2];
+    size_t tripletLayers[2];
+};
+// -------------------------------- MNA Matrix with Dense and Sparse Backends --------------------------------
+
+#endif //MNAMATRIX_H
@@ -0,0 +1,92 @@
+#include "MNASolver.h"
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+// -------------------------------- Constructor impementation --------------------------------
+MNASolver::MNASolver() : backend(MNAMatrix::Backend::SPARSE), analyzed(false) {}
+// -------------------------------- Constructor impementation --------------------------------
+
+
+// -------------------------------- Symbolic Analysis Cache --------------------------------
+void MNASolver::invalidate() {
+    analyzed = false;
+    patternOuter.clear();
+    patternInner.clear();
+}
+
+bool MNASolver::samePattern(const Eigen::SparseMatrix<double>& A) const {
+    if (patternOuter.size() != static_cast<size_t>(A.outerSize() + 1) ||
+        patternInner.size() != static_cast<size_t>(A.nonZeros()))
+        return false;
+    return std::equal(patternOuter.begin(), patternOuter.end(), A.outerIndexPtr()) &&
+           std::equal(patternInner.begin(), patternInner.end(), A.innerIndexPtr());
+}
+// -------------------------------- Symbolic Analysis Cache --------------------------------
+
+
+// -------------------------------- Factorize and Solve --------------------------------
+bool MNASolver::factorize(const MNAMatrix& A) {
+    if (backend != A.getBackend()) {
+        invalidate();
+        backend = A.getBackend();
+    }
+
+    if (backend == MNAMatrix::Backend::DENSE) {
+        // Structurally singular circuits are rejected before this (TopologyCheck), so partial pivoting
+        // is enough. Row pivoting leaves the columns in place, so pivot k belongs to column k.
+        const Eigen::MatrixXd& D = A.dense();
+        denseLU.compute(D);
+        return pivotsRegular(denseLU.matrixLU().diagonal().cwiseAbs(),
+                             D.cwiseAbs().colwise().maxCoeff().transpose());
+    }
+
+    // A stamp that is skipped in some analyses (e.g. capacitors at h = 0) changes the pattern, so the
+    // cached analysis is only trusted when the structure really matches.
+    const Eigen::SparseMatrix<double>& S = A.sparse();
+    if (!analyzed || !samePattern(S)) {
+        sparseLU.analyzePattern(S);
+        patternOuter.assign(S.outerIndexPtr(), S.outerIndexPtr() + S.outerSize() + 1);
+        patternInner.assign(S.innerIndexPtr(), S.innerIndexPtr() + S.nonZeros());
+        analyzed = true;
+    }
+    sparseLU.factorize(S);
+    if (sparseLU.info() != Eigen::Success)
+        return false;
+
+    // Same test as the dense path. The diagonal of U sits in the supernodes of L, and pivot j belongs
+    // to the column the COLAMD ordering moved to position j.
+    Eigen::VectorXd columnScale = Eigen::VectorXd::Zero(S.cols());
+    for (int j = 0; j < S.outerSize(); ++j)
+        for (Eigen::SparseMatrix<double>::InnerIterator it(S, j); it; ++it)
+            columnScale(j) = std::max(columnScale(j), std::abs(it.value()));
+    const auto& supernodes = sparseLU.matrixL().m_mapL;
+    Eigen::VectorXd pivots = Eigen::VectorXd::Zero(S.cols());
+    for (int j = 0; j < S.cols(); ++j)
+        for (std::decay_t<decltype(supernodes)>::InnerIterator it(supernodes, j); it; ++it)
+            if (it.row() == j) {
+                pivots(j) = std::abs(it.value());
+                break;
+            }
+    return pivotsRegular(pivots, sparseLU.colsPermutation() * columnScale);
+}
+
+// Values can make a structurally sound matrix singular (e.g. dependent controlled sources), which
+// round-off turns into tiny pivots rather than zeros. A pivot is measured against the largest entry of
+// its own column, so badly scaled but regular circuits (GMIN next to a 1 mOhm resistor) still pass.
+bool MNASolver::pivotsRegular(const Eigen::VectorXd& pivots, const Eigen::VectorXd& columnScale) {
+    if (!pivots.allFinite())
+        return false;
+    const double tolerance = pivots.size() * Eigen::NumTraits<double>::epsilon();
+    for (int j = 0; j < pivots.size(); ++j)
+        if (pivots(j) <= tolerance * columnScale(j))
+            return false;
+    return true;
+}
+
+Eigen::VectorXd MNASolver::solve(const Eigen::VectorXd& b) const {
+    if (backend == MNAMatrix::Backend::DENSE)
+        return denseLU.solve(b);
+    return sparseLU.solve(b);
+}
+// -------------------------------- Factorize and Solve --------------------------------
@@ -0,0 +1,36 @@
+#ifndef MNASOLVER_H
+#define MNASOLVER_H
+
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+#include <Eigen/SparseLU>
+#include <vector>
+#include "MNAMatrix.h"
+
+// -------------------------------- Solver Context for the MNA System --------------------------------
+// Owned by Circuit. For the sparse backend the column ordering and symbolic analysis are done once per
+// sparsity pattern, and every later factorize() call only redoes the numeric factorization. The context
+// is invalidated by Circuit whenever the topology changes.
+class MNASolver {
+public:
+    MNASolver();
+
+    void invalidate();
+    bool factorize(const MNAMatrix& A);
+    Eigen::VectorXd solve(const Eigen::VectorXd& b) const;
+
+private:
+    bool samePattern(const Eigen::SparseMatrix<double>& A) const;
+    static bool pivotsRegular(const Eigen::VectorXd& pivots, const Eigen::VectorXd& columnScale);
+
+    MNAMatrix::Backend backend;
+    bool analyzed;
+    std::vector<int> patternOuter;
+    std::vector<int> patternInner;
+
+    Eigen::SparseLU<Eigen::SparseMatrix<double>, Eigen::COLAMDOrdering<int>> sparseLU;
+    Eigen::PartialPivLU<Eigen::MatrixXd> denseLU;
+};
+// -------------------------------- Solver Context for the MNA System --------------------------------
+
+#endif //MNASOLVER_H
@@ -1,4 +1,7 @@
 #include "PlotWindow.h"
+#include <algorithm>
+#include <limits>
+#include <cmath>
 
 PlotWindow::PlotWindow(QWidget *parent)
     : QMainWindow(parent) {
@@ -12,17 +15,24 @@ PlotWindow::PlotWindow(QWidget *parent)
     series = new QLineSeries();
     chart->addSeries(series);
 
-    QValueAxis *axisX = new QValueAxis();
+    chartView->setRubberBand(QChartView::RectangleRubberBand);
+
+    axisX = new QValueAxis();
     axisX->setTitleText("Time");
     chart->addAxis(axisX, Qt::AlignBottom);
     series->attachAxis(axisX);
 
-    QValueAxis *axisY = new QValueAxis();
+    axisY = new QValueAxis();
     axisY->setTitleText("Value");
     chart->addAxis(axisY, Qt::AlignLeft);
     series->attachAxis(axisY);
 
     setCentralWidget(chartView);
+
+    // Zooming and panning change the visible range, so the decimated series is rebuilt for it
+    connect(axisX, &QValueAxis::rangeChanged, this, &PlotWindow::rebuildSeries);
+    // and so does resizing, once the chart has laid out its new plot area
+    connect(chart, &QChart::plotAreaChanged, this, &PlotWindow::rebuildSeries);
 }
 
 PlotWindow::~PlotWindow() {
@@ -36,10 +46,203 @@ void PlotWindow::plotData(const std::vector<double>& time, const std::vector<dou
         return;
     }
 
-    series->clear();
-    for (size_t i = 0; i < time.size(); ++i) {
-        series->append(time[i], values[i]);
+    ownedTime = time;
+    ownedValues = values;
+    rawFile.reset();
+    setData(ownedTime.size(), [this](size_t i) { return ownedTime[i]; }, [this](size_t i) { return ownedValues[i]; }, title);
+}
+
+// Reads the points straight out of a mapped .raw file
+void PlotWindow::plotData(std::shared_ptr<RawFileReader> reader, int index, const QString& title) {
+    RawFileReader::SignalView time = reader->signal(0);
+    RawFileReader::SignalView values = reader->signal(index);
+
+    ownedTime.clear();
+    ownedValues.clear();
+    rawFile = std::move(reader);
+    setData(time.size(), [time](size_t i) { return time[i]; }, [values](size_t i) { return values[i]; }, title);
+}
+
+void PlotWindow::setData(size_t count, std::function<double(size_t)> x, std::function<double(size_t)> y, const QString& title) {
+    pointCount = count;
+    timeAt = std::move(x);
+    valueAt = std::move(y);
+    chart->setTitle(title);
+    if (pointCount == 0) {
+        series->clear();
+        return;
+    }
+
+    double yMin = std::numeric_limits<double>::infinity();
+    double yMax = -std::numeric_limits<double>::infinity();
+    for (size_t i = 0; i < pointCount; ++i) {
+        yMin = std::min(yMin, valueAt(i));
+        yMax = std::max(yMax, valueAt(i));
+    }
+    if (yMin == yMax) {
+        yMin -= 1.0;
+        yMax += 1.0;
+    }
+    axisY->setRange(yMin, yMax);
+
+    double xMin = timeAt(0), xMax = timeAt(pointCount - 1);
+    if (xMin == xMax)
+        xMax = xMin + 1.0;
+    // A new range emits rangeChanged, which rebuilds the series; an unchanged one does not
+    if (axisX->min() == xMin && axisX->max() == xMax)
+        rebuildSeries();
+    else
+        axisX->setRange(xMin, xMax);
+}
+
+// Time is ascending, so the visible window is found by binary search.
+size_t PlotWindow::firstIndexAtOrAfter(double x) const {
+    size_t low = 0, high = pointCount;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (timeAt(mid) < x)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+int PlotWindow::plotPixels() const {
+    return std::max(1, static_cast<int>(chart->plotArea().width()));
+}
+
+// Adds the samples of one bucket, lowest and highest, in time order
+void PlotWindow::appendMinMax(QList<QPointF>& points, size_t minIndex, size_t maxIndex) const {
+    size_t a = std::min(minIndex, maxIndex), b = std::max(minIndex, maxIndex);
+    points.append(QPointF(timeAt(a), valueAt(a)));
+    if (b != a)
+        points.append(QPointF(timeAt(b), valueAt(b)));
+}
+
+// Min/max decimation: the visible range is split into one bucket per horizontal pixel and each bucket
+// contributes its lowest and highest sample, in time order. That keeps every spike visible with at most
+// two points per pixel, and the result reaches Qt Charts in a single replace() call.
+void PlotWindow::rebuildSeries() {
+    if (live)
+        restartLiveBuckets();
+    if (pointCount == 0 || !timeAt)
+        return;
+
+    double xMin = axisX->min(), xMax = axisX->max();
+    int pixels = plotPixels();
+
+    // One sample beyond each edge, so the line runs on to the border of the plot
+    size_t first = firstIndexAtOrAfter(xMin);
+    size_t last = firstIndexAtOrAfter(xMax);
+    if (first > 0) first--;
+    if (last < pointCount) last++;
+
+    QList<QPointF> points;
+    if (last - first <= static_cast<size_t>(2 * pixels)) {
+        points.reserve(static_cast<qsizetype>(last - first));
+        for (size_t i = first; i < last; ++i)
+            points.append(QPointF(timeAt(i), valueAt(i)));
+        series->replace(points);
+        return;
+    }
+
+    points.reserve(2 * pixels + 4);
+    double bucketWidth = (xMax - xMin) / pixels;
+    long bucket = std::numeric_limits<long>::min();
+    size_t minIndex = first, maxIndex = first;
+
+    for (size_t i = first; i < last; ++i) {
+        double t = timeAt(i);
+        long b = static_cast<long>(std::floor((t - xMin) / bucketWidth));
+        if (b != bucket) {
+            if (bucket != std::numeric_limits<long>::min())
+                appendMinMax(points, minIndex, maxIndex);
+            bucket = b;
+            minIndex = maxIndex = i;
+            continue;
+        }
+        double v = valueAt(i);
+        if (v < valueAt(minIndex)) minIndex = i;
+        if (v > valueAt(maxIndex)) maxIndex = i;
     }
+    appendMinMax(points, minIndex, maxIndex);
+    series->replace(points);
+}
 
+// While a simulation runs the time axis stays at [startTime, stopTime], so the pixel buckets do not move
+// and a batch only touches the buckets at the end of the series: the still open last bucket is taken off
+// and everything from it on is appended again. The cost per batch is the batch size, not the series size.
+void PlotWindow::beginLivePlot(double startTime, double stopTime, const QString& title) {
+    live = true;
+    ownedTime.clear();
+    ownedValues.clear();
+    pointCount = 0;
+    timeAt = [this](size_t i) { return ownedTime[i]; };
+    valueAt = [this](size_t i) { return ownedValues[i]; };
+    liveValueMin = std::numeric_limits<double>::infinity();
+    liveValueMax = -std::numeric_limits<double>::infinity();
     chart->setTitle(title);
+    series->clear();
+    axisX->setRange(startTime, stopTime > startTime ? stopTime : startTime + 1.0);
+    restartLiveBuckets();
+}
+
+// After a full rebuild the series ends with complete buckets, so the next batch starts a fresh one.
+void PlotWindow::restartLiveBuckets() {
+    liveOrigin = axisX->min();
+    liveBucketWidth = (axisX->max() - axisX->min()) / plotPixels();
+    liveBucket = std::numeric_limits<long>::min();
+    liveTailCount = 0;
+}
+
+void PlotWindow::appendLivePoints(const QList<QPointF>& points) {
+    if (!live || points.isEmpty())
+        return;
+
+    size_t first = ownedTime.size();
+    for (const QPointF& p : points) {
+        ownedTime.push_back(p.x());
+        ownedValues.push_back(p.y());
+        liveValueMin = std::min(liveValueMin, p.y());
+        liveValueMax = std::max(liveValueMax, p.y());
+    }
+    pointCount = ownedTime.size();
+
+    QList<QPointF> tail;
+    int removeCount = liveTailCount;
+    for (size_t i = first; i < pointCount; ++i) {
+        long b = static_cast<long>(std::floor((ownedTime[i] - liveOrigin) / liveBucketWidth));
+        if (b != liveBucket) {
+            if (liveBucket != std::numeric_limits<long>::min())
+                appendMinMax(tail, liveMinIndex, liveMaxIndex);
+            liveBucket = b;
+            liveMinIndex = liveMaxIndex = i;
+            continue;
+        }
+        if (ownedValues[i] < ownedValues[liveMinIndex]) liveMinIndex = i;
+        if (ownedValues[i] > ownedValues[liveMaxIndex]) liveMaxIndex = i;
+    }
+    qsizetype closedCount = tail.size();
+    appendMinMax(tail, liveMinIndex, liveMaxIndex);
+    liveTailCount = static_cast<int>(tail.size() - closedCount);
+
+    if (removeCount > 0)
+        series->removePoints(series->count() - removeCount, removeCount);
+    series->append(tail);
+
+    if (liveValueMin < axisY->min() || liveValueMax > axisY->max() || first == 0) {
+        double low = liveValueMin, high = liveValueMax;
+        if (low == high) {
+            low -= 1.0;
+            high += 1.0;
+        }
+        axisY->setRange(low, high);
+    }
+}
+
+// Back to a normal plot over the whole result, zoomable like any other
+void PlotWindow::endLivePlot(const QString& title) {
+    live = false;
+    setData(ownedTime.size(), [this](size_t i) { return ownedTime[i]; }, [this](size_t i) { return ownedValues[i]; }, title);
 }
@@ -7,6 +7,9 @@
 #include <QtCharts/QLineSeries>
 #include <QtCharts/QValueAxis>
 #include <QVBoxLayout>
+#include <functional>
+#include <memory>
+#include "RawFileReader.h"
 
 //QT_CHARTS_USE_NAMESPACE
 
@@ -18,11 +21,45 @@ public:
     ~PlotWindow();
 
     void plotData(const std::vector<double>& time, const std::vector<double>& values, const QString& title);
+    // Plots signal `index` of a .raw file against its sweep axis. The window keeps the reader, and with it
+    // the mapping the points are read from, for as long as it shows them.
+    void plotData(std::shared_ptr<RawFileReader> reader, int index, const QString& title);
+
+    // Live mode: the time axis is fixed to [startTime, stopTime] and batches of points are appended as a
+    // simulation produces them. endLivePlot() turns the collected points into a normal plot.
+    void beginLivePlot(double startTime, double stopTime, const QString& title);
+    void appendLivePoints(const QList<QPointF>& points);
+    void endLivePlot(const QString& title);
+
+private slots:
+    void rebuildSeries();
 
 private:
+    void setData(size_t count, std::function<double(size_t)> x, std::function<double(size_t)> y, const QString& title);
+    size_t firstIndexAtOrAfter(double x) const;
+    int plotPixels() const;
+    void appendMinMax(QList<QPointF>& points, size_t minIndex, size_t maxIndex) const;
+    void restartLiveBuckets();
+
     QChart *chart;
     QChartView *chartView;
     QLineSeries *series;
+    QValueAxis *axisX;
+    QValueAxis *axisY;
+
+    // Full resolution data; the series only ever holds the decimated view of it
+    std::vector<double> ownedTime, ownedValues;
+    std::shared_ptr<RawFileReader> rawFile;
+    std::function<double(size_t)> timeAt, valueAt;
+    size_t pointCount = 0;
+
+    // Live mode state: bucket grid, the open last bucket and how many series points it occupies
+    bool live = false;
+    double liveOrigin = 0.0, liveBucketWidth = 1.0;
+    long liveBucket = 0;
+    size_t liveMinIndex = 0, liveMaxIndex = 0;
+    int liveTailCount = 0;
+    double liveValueMin = 0.0, liveValueMax = 0.0;
 };
 
-#endif // PLOTWINDOW_H
\ No newline at end of file
+#endif // PLOTWINDOW_H
@@ -0,0 +1,200 @@
+#include "RawFileReader.h"
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// -------------------------------- Constructor and Destructor --------------------------------
+RawFileReader::RawFileReader(const std::string& path)
+    : mapped(nullptr), mappedSize(0),
+#ifdef _WIN32
+      fileHandle(INVALID_HANDLE_VALUE), mappingHandle(nullptr),
+#else
+      fileDescriptor(-1),
+#endif
+      pointCount(0), records(nullptr) {
+    map(path);
+    try {
+        parseHeader();
+    } catch (...) {
+        unmap();
+        throw;
+    }
+}
+
+RawFileReader::~RawFileReader() {
+    unmap();
+}
+// -------------------------------- Constructor and Destructor --------------------------------
+
+
+// -------------------------------- File Mapping --------------------------------
+void RawFileReader::map(const std::string& path) {
+#ifdef _WIN32
+    fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                             FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("Could not open file '" + path + "' for reading.");
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(fileHandle, &size) || size.QuadPart == 0) {
+        unmap();
+        throw std::runtime_error("File '" + path + "' is empty or unreadable.");
+    }
+    mappedSize = static_cast<size_t>(size.QuadPart);
+    mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mappingHandle)
+        mapped = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+#else
+    fileDescriptor = open(path.c_str(), O_RDONLY);
+    if (fileDescriptor == -1)
+        throw std::runtime_error("Could not open file '" + path + "' for reading.");
+    struct stat info;
+    if (fstat(fileDescriptor, &info) != 0 || info.st_size == 0) {
+        unmap();
+        throw std::runtime_error("File '" + path + "' is empty or unreadable.");
+    }
+    mappedSize = static_cast<size_t>(info.st_size);
+    void* address = mmap(nullptr, mappedSize, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+    if (address != MAP_FAILED)
+        mapped = static_cast<const char*>(address);
+#endif
+    if (!mapped) {
+        unmap();
+        throw std::runtime_error("Could not map file '" + path + "' into memory.");
+    }
+}
+
+void RawFileReader::unmap() {
+#ifdef _WIN32
+    if (mapped)
+        UnmapViewOfFile(mapped);
+    if (mappingHandle)
+        CloseHandle(mappingHandle);
+    if (fileHandle != INVALID_HANDLE_VALUE)
+        CloseHandle(fileHandle);
+    mappingHandle = nullptr;
+    fileHandle = INVALID_HANDLE_VALUE;
+#else
+    if (mapped)
+        munmap(const_cast<char*>(mapped), mappedSize);
+    if (fileDescriptor != -1)
+        close(fileDescriptor);
+    fileDescriptor = -1;
+#endif
+    mapped = nullptr;
+    mappedSize = 0;
+}
+// -------------------------------- File Mapping --------------------------------
+
+
+// -------------------------------- Header Parsing --------------------------------
+// A count field the writer never filled in (a streamed file whose run did not finish) is blank padding;
+// it reads as unknown instead of failing the whole file.
+static bool parseCount(const std::string& value, size_t& count) {
+    size_t used = 0;
+    unsigned long parsed;
+    try {
+        parsed = std::stoul(value, &used);
+    } catch (const std::exception&) {
+        return false;
+    }
+    if (value.find_first_not_of(" \t", used) != std::string::npos)
+        return false;
+    count = parsed;
+    return true;
+}
+
+// Only the header is read here; the binary part stays untouched until a signal is accessed.
+void RawFileReader::parseHeader() {
+    static const char BINARY_MARKER[] = "Binary:\n";
+    const char* end = mapped + mappedSize;
+    const char* binary = std::search(mapped, end, BINARY_MARKER, BINARY_MARKER + sizeof(BINARY_MARKER) - 1);
+    if (binary == end)
+        throw std::runtime_error("Not a binary .raw file (no 'Binary:' section).");
+
+    std::istringstream header(std::string(mapped, binary));
+    std::string line;
+    size_t variableCount = 0;
+    bool pointCountKnown = false;
+    bool inVariables = false;
+    while (std::getline(header, line)) {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (inVariables && !line.empty() && std::isspace(static_cast<unsigned char>(line[0]))) {
+            std::istringstream fields(line);
+            std::string index, name;
+            fields >> index >> name;
+            variableNames.push_back(name);
+            continue;
+        }
+        inVariables = false;
+
+        size_t colon = line.find(':');
+        if (colon == std::string::npos)
+            continue;
+        std::string key = line.substr(0, colon);
+        std::string value = line.substr(colon + 1);
+        value.erase(0, value.find_first_not_of(" \t"));
+
+        if (key == "Plotname")
+            plotName = value;
+        else if (key == "Flags" && value.find("complex") != std::string::npos)
+            throw std::runtime_error("Complex .raw data is not supported.");
+        else if (key == "No. Variables")
+            variableCount = std::stoul(value);
+        else if (key == "No. Points")
+            pointCountKnown = parseCount(value, pointCount);
+        else if (key == "Variables")
+            inVariables = true;
+    }
+
+    if (variableCount == 0 || variableNames.size() != variableCount)
+        throw std::runtime_error("Malformed .raw header: variable list does not match 'No. Variables'.");
+
+    const char* data = binary + sizeof(BINARY_MARKER) - 1;
+    size_t available = static_cast<size_t>(end - data) / (variableCount * sizeof(double));
+    // A streamed file that was cut short holds fewer points than announced, or none when the count was
+    // never written; either way only the complete records are read.
+    pointCount = pointCountKnown ? std::min(pointCount, available) : available;
+    records = data;
+}
+// -------------------------------- Header Parsing --------------------------------
+
+
+// -------------------------------- Signal Access --------------------------------
+int RawFileReader::findVariable(const std::string& name) const {
+    auto lower = [](std::string s) {
+        std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return std::tolower(c); });
+        return s;
+    };
+    std::string wanted = lower(name);
+    for (size_t i = 0; i < variableNames.size(); ++i)
+        if (lower(variableNames[i]) == wanted)
+            return static_cast<int>(i);
+    return -1;
+}
+
+RawFileReader::SignalView RawFileReader::signal(int index) const {
+    if (index < 0 || index >= static_cast<int>(variableNames.size()))
+        throw std::runtime_error("Signal index out of range.");
+    size_t recordSize = variableNames.size() * sizeof(double);
+    return SignalView(records + index * sizeof(double), pointCount, recordSize);
+}
+
+std::vector<double> RawFileReader::SignalView::toVector() const {
+    std::vector<double> values(count);
+    for (size_t i = 0; i < count; ++i)
+        values[i] = (*this)[i];
+    return values;
+}
+// -------------------------------- Signal Access --------------------------------
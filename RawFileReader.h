@@ -0,0 +1,65 @@
+#ifndef RAWFILEREADER_H
+#define RAWFILEREADER_H
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// -------------------------------- Memory-Mapped .raw Waveform Reader --------------------------------
+// Opens a binary .raw file (as written by RawFileWriter or ngspice) by mapping it into memory, so opening
+// costs the same for any file size and only the pages that are actually read are loaded. Signals are
+// exposed as strided views straight into the mapping.
+class RawFileReader {
+public:
+    // One variable across all points, element i is the double at data + i * stride bytes. The data
+    // section follows a text header of any length, so values are copied out rather than dereferenced.
+    class SignalView {
+    public:
+        SignalView(const char* d, size_t n, size_t s) : data(d), count(n), stride(s) {}
+        double operator[](size_t i) const {
+            double value;
+            std::memcpy(&value, data + i * stride, sizeof(double));
+            return value;
+        }
+        size_t size() const { return count; }
+        std::vector<double> toVector() const;
+    private:
+        const char* data;
+        size_t count;
+        size_t stride;
+    };
+
+    explicit RawFileReader(const std::string& path);
+    ~RawFileReader();
+    RawFileReader(const RawFileReader&) = delete;
+    RawFileReader& operator=(const RawFileReader&) = delete;
+
+    const std::string& getPlotName() const { return plotName; }
+    const std::vector<std::string>& getVariableNames() const { return variableNames; }
+    size_t getPointCount() const { return pointCount; }
+    int findVariable(const std::string& name) const;  // -1 when missing, case insensitive
+    SignalView signal(int index) const;                // index 0 is the sweep axis (time)
+
+private:
+    void map(const std::string& path);
+    void unmap();
+    void parseHeader();
+
+    const char* mapped;
+    size_t mappedSize;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#else
+    int fileDescriptor;
+#endif
+
+    std::string plotName;
+    std::vector<std::string> variableNames;
+    size_t pointCount;
+    const char* records;
+};
+// -------------------------------- Memory-Mapped .raw Waveform Reader --------------------------------
+
+#endif //RAWFILEREADER_H
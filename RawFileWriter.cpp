@@ -0,0 +1,67 @@
+#include "RawFileWriter.h"
+#include <ctime>
+#include <stdexcept>
+
+static const int POINT_COUNT_WIDTH = 20;
+
+// -------------------------------- Constructor impementation --------------------------------
+RawFileWriter::RawFileWriter(const std::string& p, const std::string& t, const std::string& plot,
+                             const std::string& axis, const std::string& type)
+    : buffer(1 << 20), path(p), title(t), plotName(plot), axisName(axis), axisType(type), pointCount(0) {
+    file.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+    file.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+        throw std::runtime_error("Could not open file '" + path + "' for writing.");
+}
+// -------------------------------- Constructor impementation --------------------------------
+
+
+// -------------------------------- Header and Data --------------------------------
+// V(...) signals are voltages, I(...) signals device currents
+static const char* signalType(const std::string& name) {
+    return name.rfind("I(", 0) == 0 ? "device_current" : "voltage";
+}
+
+void RawFileWriter::begin(const std::vector<std::string>& signalNames) {
+    char date[64];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%a %b %d %H:%M:%S %Y", std::localtime(&now));
+
+    file << "Title: * " << title << "\n";
+    file << "Date: " << date << "\n";
+    file << "Plotname: " << plotName << "\n";
+    file << "Flags: real forward double\n";
+    file << "No. Variables: " << signalNames.size() + 1 << "\n";
+    file << "No. Points: ";
+    pointCountPos = file.tellp();
+    file << std::string(POINT_COUNT_WIDTH, ' ') << "\n";
+    file << "Offset: 0.0\n";
+    file << "Variables:\n";
+    file << "\t0\t" << axisName << "\t" << axisType << "\n";
+    for (size_t i = 0; i < signalNames.size(); ++i)
+        file << "\t" << i + 1 << "\t" << signalNames[i] << "\t" << signalType(signalNames[i]) << "\n";
+    file << "Binary:\n";
+
+    record.resize(signalNames.size() + 1);
+    pointCount = 0;
+}
+
+void RawFileWriter::write(double axisValue, const Eigen::VectorXd& solution) {
+    record[0] = axisValue;
+    for (int i = 0; i < solution.size() && i + 1 < static_cast<int>(record.size()); ++i)
+        record[i + 1] = solution(i);
+    file.write(reinterpret_cast<const char*>(record.data()), record.size() * sizeof(double));
+    pointCount++;
+}
+
+void RawFileWriter::end() {
+    std::string count = std::to_string(pointCount);
+    count.resize(POINT_COUNT_WIDTH, ' ');
+    file.seekp(pointCountPos);
+    file << count;
+    file.seekp(0, std::ios::end);
+    file.flush();
+    if (!file)
+        throw std::runtime_error("Writing to '" + path + "' failed.");
+}
+// -------------------------------- Header and Data --------------------------------
@@ -0,0 +1,37 @@
+#ifndef RAWFILEWRITER_H
+#define RAWFILEWRITER_H
+
+#include "TransientSink.h"
+#include <fstream>
+#include <string>
+#include <vector>
+
+// -------------------------------- SPICE .raw Waveform Writer --------------------------------
+// Binary raw file as written by ngspice and read by LTspice: an ASCII header with the variable list,
+// followed by one record of float64 values per point (the sweep axis first, then every signal).
+// The point count is unknown while streaming, so the header reserves room for it and end() fills it in.
+// Values are written in the host byte order, which is little endian on every platform we build for.
+class RawFileWriter : public ITransientSink {
+private:
+    std::vector<char> buffer;
+    std::ofstream file;
+    std::string path;
+    std::string title;
+    std::string plotName;
+    std::string axisName;
+    std::string axisType;
+    std::streampos pointCountPos;
+    size_t pointCount;
+    std::vector<double> record;
+public:
+    // Transient analysis by default; a DC sweep passes its source as the axis
+    explicit RawFileWriter(const std::string& path, const std::string& title = "circuit",
+                           const std::string& plotName = "Transient Analysis",
+                           const std::string& axisName = "time", const std::string& axisType = "time");
+    void begin(const std::vector<std::string>& signalNames) override;
+    void write(double axisValue, const Eigen::VectorXd& solution) override;
+    void end() override;
+};
+// -------------------------------- SPICE .raw Waveform Writer --------------------------------
+
+#endif //RAWFILEWRITER_H
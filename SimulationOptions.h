@@ -0,0 +1,24 @@
+#ifndef SIMULATIONOPTIONS_H
+#define SIMULATIONOPTIONS_H
+
+#include "MNAMatrix.h"
+#include "Component.h"
+
+// -------------------------------- Options Set by .OPTIONS --------------------------------
+struct SimulationOptions {
+    MNAMatrix::Backend solver = MNAMatrix::Backend::SPARSE;           // SOLVER=DENSE|SPARSE
+    IntegrationMethod method = IntegrationMethod::TRAPEZOIDAL;        // METHOD=EULER|TRAP|GEAR
+    bool adaptiveStep = true;                                         // TIMESTEP=ADAPTIVE|FIXED
+    int threads = 0;                                                  // THREADS=n for DC sweeps, 0 = one per core
+    bool bypass = true;                                               // BYPASS=ON|OFF, skip re-evaluating settled devices
+    int luReuse = 1;                                                  // LUREUSE=n Newton iterations per LU factorization
+
+    // Tolerances of Newton convergence and the time-step control
+    double reltol = 1e-3;   // RELTOL, relative to the unknown's magnitude
+    double vntol = 1e-6;    // VNTOL, absolute for node voltages [V]
+    double abstol = 1e-12;  // ABSTOL, absolute for branch currents [A]
+    double trtol = 7.0;     // TRTOL, how much the truncation error estimate is trusted to overshoot
+};
+// -------------------------------- Options Set by .OPTIONS --------------------------------
+
+#endif //SIMULATIONOPTIONS_H
@@ -0,0 +1,80 @@
+#include "SimulationWorker.h"
+#include <QElapsedTimer>
+
+SimulationWorker::SimulationWorker(std::unique_ptr<Circuit> snapshot, double start, double stop, double step,
+                                   QObject *parent)
+    : QObject(parent), circuit(std::move(snapshot)), startTime(start), stopTime(stop), stepTime(step),
+      cancelRequested(false) {}
+
+void SimulationWorker::run() {
+    const qint64 REPORT_INTERVAL_MS = 100;
+    const qint64 LIVE_INTERVAL_MS = 33;
+    QElapsedTimer clock;
+    clock.start();
+    qint64 lastReport = 0;
+    double lastTime = startTime;
+    size_t lastPoints = 0;
+
+    // The probe column is only known once the analysis has compiled its stamps, i.e. at the first point
+    bool live = !liveProbe.empty();
+    int liveColumn = -1;
+    size_t livePointsSent = 0;
+    qint64 lastLiveBatch = 0;
+    QList<QPointF> liveBatch;
+
+    auto collectLivePoints = [&](size_t points) {
+        const TransientResultStore& store = circuit->getTransientResultStore();
+        if (livePointsSent == 0)
+            liveColumn = circuit->getProbeColumn(liveProbe);
+        for (; livePointsSent < points && livePointsSent < store.size(); ++livePointsSent) {
+            double value = liveColumn >= 0 && liveColumn < store.signalCount() ? store.value(livePointsSent, liveColumn) : 0.0;
+            liveBatch.append(QPointF(store.times()[livePointsSent], value));
+        }
+    };
+    auto flushLivePoints = [&]() {
+        if (liveBatch.isEmpty())
+            return;
+        emit pointsReady(liveBatch);
+        liveBatch.clear();
+    };
+
+    auto emitProgress = [&](double time, size_t points) {
+        qint64 elapsed = clock.elapsed();
+        double rate = elapsed > 0 ? points * 1000.0 / elapsed : 0.0;
+        emit progress(time, static_cast<qulonglong>(points), rate);
+    };
+
+    circuit->setProgressHandler([&](double time, size_t points) {
+        lastTime = time;
+        lastPoints = points;
+        if (live) {
+            collectLivePoints(points);
+            if (clock.elapsed() - lastLiveBatch >= LIVE_INTERVAL_MS) {
+                lastLiveBatch = clock.elapsed();
+                flushLivePoints();
+            }
+        }
+        if (clock.elapsed() - lastReport >= REPORT_INTERVAL_MS) {
+            lastReport = clock.elapsed();
+            emitProgress(time, points);
+        }
+        return !cancelRequested.load();
+    });
+
+    try {
+        circuit->runTransientAnalysis(stopTime, startTime, stepTime);
+    }
+    catch (const std::exception& e) {
+        circuit->setProgressHandler(nullptr);
+        emit failed(QString::fromStdString(e.what()));
+        return;
+    }
+
+    circuit->setProgressHandler(nullptr);
+    if (live) {
+        collectLivePoints(circuit->getTransientResultStore().size());
+        flushLivePoints();
+    }
+    emitProgress(lastTime, lastPoints);
+    emit finished(circuit->wasCancelled());
+}
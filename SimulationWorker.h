@@ -0,0 +1,44 @@
+#ifndef SIMULATIONWORKER_H
+#define SIMULATIONWORKER_H
+
+#include <QObject>
+#include <QList>
+#include <QPointF>
+#include <atomic>
+#include <memory>
+#include "Circuit.h"
+
+// Runs a transient analysis on a snapshot of the circuit, meant to live on its own QThread. The GUI
+// keeps editing the original circuit meanwhile and reads the results from getCircuit() after finished().
+class SimulationWorker : public QObject {
+    Q_OBJECT
+
+public:
+    SimulationWorker(std::unique_ptr<Circuit> snapshot, double startTime, double stopTime, double stepTime,
+                     QObject *parent = nullptr);
+
+    // Callable from any thread; the analysis stops after the time step in progress
+    void cancel() { cancelRequested = true; }
+    Circuit& getCircuit() { return *circuit; }
+    // Streams the probe (V(node) or I(component)) through pointsReady() while the analysis runs
+    void setLiveProbe(const std::string& parameter) { liveProbe = parameter; }
+
+public slots:
+    void run();
+
+signals:
+    // Throttled to a few updates per second
+    void progress(double simulatedTime, qulonglong steps, double stepsPerSecond);
+    // New (time, value) points of the live probe, batched to at most 30 per second
+    void pointsReady(const QList<QPointF>& points);
+    void finished(bool cancelled);
+    void failed(const QString& message);
+
+private:
+    std::unique_ptr<Circuit> circuit;
+    double startTime, stopTime, stepTime;
+    std::atomic<bool> cancelRequested;
+    std::string liveProbe;
+};
+
+#endif // SIMULATIONWORKER_H
@@ -0,0 +1,87 @@
+#include "StringInterner.h"
+#include <functional>
+
+// -------------------------------- Constructor impementation --------------------------------
+static const size_t INITIAL_SLOTS = 16;
+
+StringInterner::StringInterner() : slots(INITIAL_SLOTS, -1) {}
+// -------------------------------- Constructor impementation --------------------------------
+
+
+// -------------------------------- Lookup and Insertion --------------------------------
+// The slot that holds name, or the empty slot that ends its probe sequence
+size_t StringInterner::findSlot(const std::string& name, size_t hash) const {
+    size_t mask = slots.size() - 1;
+    for (size_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+        int id = slots[slot];
+        if (id == -1 || (hashes[id] == hash && names[id] == name))
+            return slot;
+    }
+}
+
+int StringInterner::find(const std::string& name) const {
+    return slots[findSlot(name, std::hash<std::string>{}(name))];
+}
+
+int StringInterner::intern(const std::string& name) {
+    size_t hash = std::hash<std::string>{}(name);
+    size_t slot = findSlot(name, hash);
+    if (slots[slot] != -1)
+        return slots[slot];
+
+    int id = size();
+    names.push_back(name);
+    hashes.push_back(hash);
+    slots[slot] = id;
+    if (2 * names.size() > slots.size())
+        rehash(2 * slots.size());
+    return id;
+}
+
+void StringInterner::insertSlot(int id) {
+    size_t mask = slots.size() - 1;
+    size_t slot = hashes[id] & mask;
+    while (slots[slot] != -1)
+        slot = (slot + 1) & mask;
+    slots[slot] = id;
+}
+
+void StringInterner::rehash(size_t capacity) {
+    slots.assign(capacity, -1);
+    for (int id = 0; id < size(); ++id)
+        insertSlot(id);
+}
+
+void StringInterner::clear() {
+    names.clear();
+    hashes.clear();
+    slots.assign(INITIAL_SLOTS, -1);
+}
+// -------------------------------- Lookup and Insertion --------------------------------
+
+
+// -------------------------------- Renaming --------------------------------
+// Backward-shift deletion: the entries after the hole move up into it when their probe sequence passes
+// over it, so lookups stay correct without tombstones.
+void StringInterner::eraseSlot(size_t hole) {
+    size_t mask = slots.size() - 1;
+    slots[hole] = -1;
+    for (size_t slot = (hole + 1) & mask; slots[slot] != -1; slot = (slot + 1) & mask) {
+        size_t home = hashes[slots[slot]] & mask;
+        // The entry must stay when its home lies cyclically in (hole, slot]
+        bool stays = hole <= slot ? (hole < home && home <= slot) : (hole < home || home <= slot);
+        if (!stays) {
+            slots[hole] = slots[slot];
+            slots[slot] = -1;
+            hole = slot;
+        }
+    }
+}
+
+void StringInterner::rename(int id, const std::string& newName) {
+    eraseSlot(findSlot(names[id], hashes[id]));
+    names[id] = newName;
+    hashes[id] = std::hash<std::string>{}(newName);
+    insertSlot(id);
+}
+// -------------------------------- Renaming --------------------------------
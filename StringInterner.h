@@ -0,0 +1,39 @@
+#ifndef STRINGINTERNER_H
+#define STRINGINTERNER_H
+
+#include <string>
+#include <vector>
+
+// -------------------------------- Open-Addressing String Interner --------------------------------
+// Gives every distinct string a dense id 0, 1, 2, ... in the order it was first interned. Lookups hash
+// the string once and probe a flat table of ids (linear probing, kept at most half full), so finding a
+// name costs O(1) expected time and a single string comparison on a hit, instead of O(log n) comparisons
+// in a std::map. The ids index plain vectors, which is what Circuit keeps its per-node and per-component
+// data in.
+class StringInterner {
+public:
+    StringInterner();
+
+    // Id of name, interning it when it is new
+    int intern(const std::string& name);
+    // Id of name, -1 when it was never interned
+    int find(const std::string& name) const;
+    const std::string& name(int id) const { return names[id]; }
+    int size() const { return static_cast<int>(names.size()); }
+    // Gives id a name that is not interned yet, keeping the id
+    void rename(int id, const std::string& newName);
+    void clear();
+
+private:
+    size_t findSlot(const std::string& name, size_t hash) const;
+    void insertSlot(int id);
+    void eraseSlot(size_t slot);
+    void rehash(size_t capacity);
+
+    std::vector<std::string> names;
+    std::vector<size_t> hashes; // hash of every name, so growing the table rehashes no strings
+    std::vector<int> slots;     // ids, -1 for an empty slot; the size is a power of two
+};
+// -------------------------------- Open-Addressing String Interner --------------------------------
+
+#endif //STRINGINTERNER_H
@@ -0,0 +1,154 @@
+#include "TopologyCheck.h"
+#include "DisjointSet.h"
+#include <map>
+#include <queue>
+#include <unordered_map>
+
+// -------------------------------- Element Classification --------------------------------
+// Elements that set the voltage between their terminals, so a node reached through them is not floating
+static bool connectsTerminals(const Component* comp, TopologyAnalysis analysis) {
+    switch (comp->type) {
+        case Component::Type::CURRENT_SOURCE:
+        case Component::Type::VCCS:
+        case Component::Type::CCCS:
+            return false;
+        case Component::Type::CAPACITOR:
+            return analysis == TopologyAnalysis::TRANSIENT;
+        default:
+            return true;
+    }
+}
+
+// Elements that force their terminal voltage to a value of their own; two such paths between the same
+// nodes make the branch equations dependent.
+static bool forcesVoltage(const Component* comp, TopologyAnalysis analysis) {
+    return comp->type == Component::Type::VOLTAGE_SOURCE ||
+           (comp->type == Component::Type::INDUCTOR && analysis == TopologyAnalysis::DC);
+}
+
+static std::string joinNames(const std::vector<std::string>& names) {
+    const size_t MAX_NAMES = 10;
+    std::string joined;
+    for (size_t i = 0; i < names.size() && i < MAX_NAMES; ++i)
+        joined += (i > 0 ? ", " : "") + names[i];
+    if (names.size() > MAX_NAMES)
+        joined += ", ... (" + std::to_string(names.size()) + " in total)";
+    return joined;
+}
+// -------------------------------- Element Classification --------------------------------
+
+
+// -------------------------------- Floating Nodes and Source Loops --------------------------------
+using Forest = std::vector<std::vector<std::pair<int, const Component*>>>;
+
+// The components on the path from `from` to `to` in a forest of voltage-forcing elements, with the nodes
+// they pass through. The search only visits the tree that holds both nodes.
+static void forestPath(const Forest& forest, int from, int to, std::vector<const Component*>& path,
+                       std::vector<int>& nodes) {
+    std::unordered_map<int, std::pair<int, const Component*>> cameFrom;
+    std::queue<int> pending;
+    cameFrom[from] = {from, nullptr};
+    pending.push(from);
+    while (!pending.empty() && !cameFrom.count(to)) {
+        int node = pending.front();
+        pending.pop();
+        for (const auto& [next, comp] : forest[node]) {
+            if (cameFrom.emplace(next, std::make_pair(node, comp)).second)
+                pending.push(next);
+        }
+    }
+
+    nodes.push_back(to);
+    for (int node = to; node != from; ) {
+        const auto& [previous, comp] = cameFrom.at(node);
+        path.push_back(comp);
+        nodes.push_back(previous);
+        node = previous;
+    }
+}
+
+std::vector<std::string> findTopologyProblems(const std::vector<Component*>& components,
+                                              const StringInterner& nodeNames,
+                                              const std::vector<int>& representative,
+                                              const std::set<int>& groundNodeIds, TopologyAnalysis analysis) {
+    std::vector<std::string> problems;
+    // A circuit without ground is reported by the analyses themselves
+    if (groundNodeIds.empty())
+        return problems;
+
+    int nodeCount = static_cast<int>(representative.size());
+    int ground = representative[*groundNodeIds.begin()];
+    std::set<int> groundNodes;
+    for (int id : groundNodeIds)
+        groundNodes.insert(representative[id]);
+    auto canonical = [&](int id) {
+        int node = representative[id];
+        return groundNodes.count(node) ? ground : node;
+    };
+    const bool dc = analysis == TopologyAnalysis::DC;
+
+    // Floating nodes: every set of nodes the connecting elements do not join to ground is reported with
+    // the components attached to it, which are what isolates it.
+    DisjointSet paths(nodeCount);
+    for (const Component* comp : components) {
+        if (connectsTerminals(comp, analysis))
+            paths.unite(canonical(comp->node1), canonical(comp->node2));
+    }
+
+    int groundSet = paths.find(ground);
+    std::map<int, std::vector<std::string>> islandNodes;
+    for (int node = 0; node < nodeCount; ++node) {
+        if (representative[node] == node && !groundNodes.count(node) && paths.find(node) != groundSet)
+            islandNodes[paths.find(node)].push_back(nodeNames.name(node));
+    }
+    if (!islandNodes.empty()) {
+        std::map<int, std::vector<std::string>> islandComponents;
+        for (const Component* comp : components) {
+            int set1 = paths.find(canonical(comp->node1));
+            int set2 = paths.find(canonical(comp->node2));
+            if (islandNodes.count(set1))
+                islandComponents[set1].push_back(comp->name);
+            if (set2 != set1 && islandNodes.count(set2))
+                islandComponents[set2].push_back(comp->name);
+        }
+        for (const auto& [set, nodes] : islandNodes) {
+            std::string message = std::string("No ") + (dc ? "DC " : "") + "path to ground from node" +
+                                  (nodes.size() > 1 ? "s " : " ") + joinNames(nodes);
+            auto attached = islandComponents.find(set);
+            if (attached == islandComponents.end())
+                message += " (not connected to any component)";
+            else
+                message += " (only connected to " + joinNames(attached->second) + ")";
+            problems.push_back(message);
+        }
+    }
+
+    // Source loops: an element whose terminals the earlier ones already tie together closes a loop, which
+    // is its own branch plus the path between its terminals in the forest of the earlier elements.
+    DisjointSet forced(nodeCount);
+    Forest forest(nodeCount);
+    for (const Component* comp : components) {
+        if (!forcesVoltage(comp, analysis))
+            continue;
+        int a = canonical(comp->node1), b = canonical(comp->node2);
+        if (forced.unite(a, b)) {
+            forest[a].emplace_back(b, comp);
+            forest[b].emplace_back(a, comp);
+            continue;
+        }
+
+        std::vector<const Component*> loop;
+        std::vector<int> loopNodes;
+        forestPath(forest, a, b, loop, loopNodes);
+        std::vector<std::string> elementNames{comp->name}, nodeNamesOnLoop;
+        for (const Component* element : loop)
+            elementNames.push_back(element->name);
+        for (int node : loopNodes)
+            nodeNamesOnLoop.push_back(nodeNames.name(node));
+        problems.push_back(std::string("Loop of voltage sources") + (dc ? " and inductors" : "") + ": " +
+                           joinNames(elementNames) + " (through node" + (nodeNamesOnLoop.size() > 1 ? "s " : " ") +
+                           joinNames(nodeNamesOnLoop) + ")");
+    }
+    return problems;
+}
+// -------------------------------- Floating Nodes and Source Loops --------------------------------
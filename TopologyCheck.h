@@ -0,0 +1,31 @@
+#ifndef TOPOLOGYCHECK_H
+#define TOPOLOGYCHECK_H
+
+#include <set>
+#include <string>
+#include <vector>
+#include "Component.h"
+#include "StringInterner.h"
+
+// -------------------------------- Structural Check of the Circuit Graph --------------------------------
+// Finds, from the connections alone, the circuits whose MNA matrix is singular for any element values:
+//   - nodes without a path to ground through elements that set their voltage. Current sources and the
+//     outputs of VCCS/CCCS never do; capacitors only do once there is a time step.
+//   - loops made only of independent voltage sources and, at DC where they are shorts, inductors.
+// Both are found with a union-find pass over the components, so the check is cheap enough to run once
+// per topology, and the problems are reported by node and component name instead of as a failed LU.
+enum class TopologyAnalysis {
+    DC,         // operating point and DC sweep: capacitors open, inductors short
+    TRANSIENT   // a time step from the start: capacitors and inductors are companion models
+};
+
+// One message per problem, empty when the circuit is structurally sound. Node ids are the ids of nodeNames,
+// representative[id] is the node an id belongs to after merging (see Circuit::resolveNodes), and all ground
+// nodes are one node.
+std::vector<std::string> findTopologyProblems(const std::vector<Component*>& components,
+                                              const StringInterner& nodeNames,
+                                              const std::vector<int>& representative,
+                                              const std::set<int>& groundNodeIds, TopologyAnalysis analysis);
+// -------------------------------- Structural Check of the Circuit Graph --------------------------------
+
+#endif //TOPOLOGYCHECK_H
@@ -8,18 +8,21 @@ TransientDialog::TransientDialog(QWidget *parent)
     stopTimeEdit = new QLineEdit(this);
     stepTimeEdit = new QLineEdit(this);
     parameterEdit = new QLineEdit(this);
+    livePlotCheck = new QCheckBox("Plot while simulating", this);
 
     // Set default values for convenience
     startTimeEdit->setText("0.0");
     stopTimeEdit->setText("1.0");
     stepTimeEdit->setText("0.001");
     parameterEdit->setPlaceholderText("e.g. V(n2) or I(R1)");
+    livePlotCheck->setChecked(true);
 
     QFormLayout *formLayout = new QFormLayout;
     formLayout->addRow("Start Time:", startTimeEdit);
     formLayout->addRow("Stop Time:", stopTimeEdit);
     formLayout->addRow("Step Time:", stepTimeEdit);
     formLayout->addRow("Parameter to Plot:", parameterEdit);
+    formLayout->addRow("Live Plot:", livePlotCheck);
 
     buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, this);
     connect(buttonBox, &QDialogButtonBox::accepted, this, &TransientDialog::accept);
@@ -47,3 +50,7 @@ double TransientDialog::getStepTime() const {
 QString TransientDialog::getParameter() const {
     return parameterEdit->text();
 }
+
+bool TransientDialog::isLivePlot() const {
+    return livePlotCheck->isChecked();
+}
@@ -4,6 +4,7 @@
 #include <QDialog>
 #include <QFormLayout>
 #include <QLineEdit>
+#include <QCheckBox>
 #include <QDialogButtonBox>
 #include <QVBoxLayout>
 
@@ -18,12 +19,14 @@ public:
     double getStopTime() const;
     double getStepTime() const;
     QString getParameter() const;
+    bool isLivePlot() const;
 
 private:
     QLineEdit *startTimeEdit;
     QLineEdit *stopTimeEdit;
     QLineEdit *stepTimeEdit;
     QLineEdit *parameterEdit;
+    QCheckBox *livePlotCheck;
     QDialogButtonBox *buttonBox;
 };
 
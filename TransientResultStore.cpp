@@ -0,0 +1,31 @@
+#include "TransientResultStore.h"
+#include <stdexcept>
+
+// -------------------------------- Append and Clear --------------------------------
+void TransientResultStore::clear() {
+    timeColumn.clear();
+    columns.clear();
+}
+
+// The number of columns is fixed by the first point of a run.
+void TransientResultStore::append(double time, const Eigen::VectorXd& solution) {
+    if (timeColumn.empty())
+        columns.assign(solution.size(), {});
+    else if (solution.size() != signalCount())
+        throw std::runtime_error("Transient result size changed during the analysis.");
+
+    timeColumn.push_back(time);
+    for (int i = 0; i < solution.size(); ++i)
+        columns[i].push_back(solution(i));
+}
+// -------------------------------- Append and Clear --------------------------------
+
+
+// -------------------------------- Row Access --------------------------------
+Eigen::VectorXd TransientResultStore::point(size_t point) const {
+    Eigen::VectorXd solution(signalCount());
+    for (int i = 0; i < signalCount(); ++i)
+        solution(i) = columns[i][point];
+    return solution;
+}
+// -------------------------------- Row Access --------------------------------
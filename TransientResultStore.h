@@ -0,0 +1,30 @@
+#ifndef TRANSIENTRESULTSTORE_H
+#define TRANSIENTRESULTSTORE_H
+
+#include <Eigen/Dense>
+#include <vector>
+
+// -------------------------------- Columnar Store for Transient Results --------------------------------
+// One contiguous time column and one contiguous column per MNA unknown. Appending a time point costs a
+// push_back per column, and a single probe is read back as one flat array.
+class TransientResultStore {
+public:
+    void clear();
+    void append(double time, const Eigen::VectorXd& solution);
+
+    size_t size() const { return timeColumn.size(); }
+    bool empty() const { return timeColumn.empty(); }
+    int signalCount() const { return static_cast<int>(columns.size()); }
+
+    const std::vector<double>& times() const { return timeColumn; }
+    const std::vector<double>& signal(int index) const { return columns.at(index); }
+    double value(size_t point, int index) const { return columns[index][point]; }
+    Eigen::VectorXd point(size_t point) const;
+
+private:
+    std::vector<double> timeColumn;
+    std::vector<std::vector<double>> columns;
+};
+// -------------------------------- Columnar Store for Transient Results --------------------------------
+
+#endif //TRANSIENTRESULTSTORE_H
@@ -0,0 +1,52 @@
+#include "TransientSink.h"
+#include "RawFileWriter.h"
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+// -------------------------------- CSV Sink --------------------------------
+CsvTransientSink::CsvTransientSink(const std::string& p) : buffer(1 << 20), path(p) {
+    file.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+    file.open(path, std::ios::out | std::ios::trunc);
+    if (!file.is_open())
+        throw std::runtime_error("Could not open file '" + path + "' for writing.");
+    file.precision(12);
+}
+
+void CsvTransientSink::begin(const std::vector<std::string>& signalNames) {
+    file << "time";
+    for (const auto& name : signalNames)
+        file << ',' << name;
+    file << '\n';
+}
+
+void CsvTransientSink::write(double time, const Eigen::VectorXd& solution) {
+    file << time;
+    for (int i = 0; i < solution.size(); ++i)
+        file << ',' << solution(i);
+    file << '\n';
+}
+
+void CsvTransientSink::end() {
+    file.flush();
+    if (!file)
+        throw std::runtime_error("Writing to '" + path + "' failed.");
+}
+// -------------------------------- CSV Sink --------------------------------
+
+
+// -------------------------------- Sink Selection --------------------------------
+std::unique_ptr<ITransientSink> createTransientSink(const std::string& path) {
+    std::string extension;
+    size_t dot = path.find_last_of('.');
+    if (dot != std::string::npos)
+        extension = path.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+
+    if (extension == "csv")
+        return std::make_unique<CsvTransientSink>(path);
+    if (extension == "raw")
+        return std::make_unique<RawFileWriter>(path);
+    throw std::runtime_error("Unsupported output format '" + path + "'. Use a .csv or .raw file.");
+}
+// -------------------------------- Sink Selection --------------------------------
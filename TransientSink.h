@@ -0,0 +1,38 @@
+#ifndef TRANSIENTSINK_H
+#define TRANSIENTSINK_H
+
+#include <Eigen/Dense>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// -------------------------------- Streaming Sinks for Transient Results --------------------------------
+// A transient analysis given a sink hands every accepted time point to it as soon as it is solved and
+// keeps nothing in memory itself. begin() receives the signal names in MNA order, one per solution entry.
+class ITransientSink {
+public:
+    virtual ~ITransientSink() = default;
+    virtual void begin(const std::vector<std::string>& /*signalNames*/) {}
+    virtual void write(double time, const Eigen::VectorXd& solution) = 0;
+    virtual void end() {}
+};
+
+// Comma separated text, one row per time point
+class CsvTransientSink : public ITransientSink {
+private:
+    std::vector<char> buffer;
+    std::ofstream file;
+    std::string path;
+public:
+    explicit CsvTransientSink(const std::string& path);
+    void begin(const std::vector<std::string>& signalNames) override;
+    void write(double time, const Eigen::VectorXd& solution) override;
+    void end() override;
+};
+
+// Picks the sink from the file extension of path
+std::unique_ptr<ITransientSink> createTransientSink(const std::string& path);
+// -------------------------------- Streaming Sinks for Transient Results --------------------------------
+
+#endif //TRANSIENTSINK_H
@@ -1,18 +1,128 @@
 #include "WaveForm.h"
+#include <algorithm>
 
 // -------------------------------- Constructor impementation --------------------------------
 DCWaveform::DCWaveform(double value) : dcValue(value) {}
 
 SinusoidalWaveform::SinusoidalWaveform(double o, double a, double f) : offset(o), amplitude(a), frequency(f) {}
+
+PulseWaveform::PulseWaveform(const std::vector<double>& params)
+    : v1(params.at(0)), v2(params.at(1)), delay(0.0), rise(0.0), fall(0.0),
+      width(std::numeric_limits<double>::infinity()), period(std::numeric_limits<double>::infinity()) {
+    if (params.size() > 2) delay = params[2];
+    if (params.size() > 3) rise = params[3];
+    if (params.size() > 4) fall = params[4];
+    if (params.size() > 5) width = params[5];
+    if (params.size() > 6 && params[6] > 0.0) period = params[6];
+}
+
+PwlWaveform::PwlWaveform(const std::vector<double>& params) : cursor(0) {
+    times.reserve(params.size() / 2);
+    values.reserve(params.size() / 2);
+    for (size_t i = 0; i + 1 < params.size(); i += 2) {
+        times.push_back(params[i]);
+        values.push_back(params[i + 1]);
+    }
+}
 // -------------------------------- Constructor impementation --------------------------------
 
 
 // -------------------------------- Get value --------------------------------
-double DCWaveform::getValue(double time) const {
+double DCWaveform::getValue(double /*time*/) const {
     return dcValue;
 }
 
 double SinusoidalWaveform::getValue(double time) const {
     return offset + amplitude * sin(2 * PI * frequency * time);
 }
-// -------------------------------- Get value --------------------------------
\ No newline at end of file
+
+double PulseWaveform::getValue(double time) const {
+    if (time < delay)
+        return v1;
+    double t = time - delay;
+    if (std::isfinite(period))
+        t = std::fmod(t, period);
+
+    if (t < rise)
+        return v1 + (v2 - v1) * t / rise;
+    t -= rise;
+    if (t < width)
+        return v2;
+    t -= width;
+    if (t < fall)
+        return v2 + (v1 - v2) * t / fall;
+    return v1;
+}
+
+double PwlWaveform::getValue(double time) const {
+    size_t n = times.size();
+    if (time <= times.front())
+        return values.front();
+    if (time >= times.back())
+        return values.back();
+
+    // times.front() < time < times.back(), so both walks stop inside the table.
+    if (cursor > n - 2)
+        cursor = n - 2;
+    while (times[cursor + 1] < time)
+        ++cursor;
+    while (times[cursor] > time)
+        --cursor;
+
+    double dt = times[cursor + 1] - times[cursor];
+    if (dt <= 0.0)
+        return values[cursor + 1];
+    return values[cursor] + (values[cursor + 1] - values[cursor]) * (time - times[cursor]) / dt;
+}
+// -------------------------------- Get value --------------------------------
+
+
+// -------------------------------- Breakpoints and step limits --------------------------------
+// At least 20 points per period, so a sine is never stepped over by a quiet circuit.
+double SinusoidalWaveform::getMaxStep(double /*time*/) const {
+    if (frequency <= 0.0 || amplitude == 0.0)
+        return std::numeric_limits<double>::infinity();
+    return 1.0 / (20.0 * frequency);
+}
+
+// The four corners of every period that overlaps [from, to].
+void PulseWaveform::getBreakpoints(double from, double to, std::vector<Breakpoint>& out) const {
+    const double corners[4] = {0.0, rise, rise + width, rise + width + fall};
+    long k = 0;
+    if (std::isfinite(period) && from > delay)
+        k = static_cast<long>(std::floor((from - delay) / period));
+
+    for (;; ++k) {
+        double start = delay + (k > 0 ? k * period : 0.0);
+        if (start > to)
+            break;
+        for (double corner : corners) {
+            double t = start + corner;
+            if (t >= from && t <= to)
+                out.push_back({t, true});
+        }
+        if (!std::isfinite(period))
+            break;
+    }
+}
+
+// The samples where the slope changes; points on a straight run are left out. A sample repeated at the
+// same time is a step in the value and a hard breakpoint.
+void PwlWaveform::getBreakpoints(double from, double to, std::vector<Breakpoint>& out) const {
+    size_t n = times.size();
+    size_t first = std::lower_bound(times.begin(), times.end(), from) - times.begin();
+    for (size_t i = first; i < n && times[i] <= to; ++i) {
+        double dtBefore = i > 0 ? times[i] - times[i - 1] : 0.0;
+        double dtAfter = i + 1 < n ? times[i + 1] - times[i] : 0.0;
+        if ((i > 0 && dtBefore <= 0.0) || (i + 1 < n && dtAfter <= 0.0)) {
+            out.push_back({times[i], true});
+            continue;
+        }
+        // Flat before the first sample and after the last
+        double slopeBefore = i > 0 ? (values[i] - values[i - 1]) / dtBefore : 0.0;
+        double slopeAfter = i + 1 < n ? (values[i + 1] - values[i]) / dtAfter : 0.0;
+        if (std::abs(slopeAfter - slopeBefore) > 1e-9 * std::max(std::abs(slopeBefore), std::abs(slopeAfter)))
+            out.push_back({times[i], false});
+    }
+}
+// -------------------------------- Breakpoints and step limits --------------------------------
@@ -2,13 +2,30 @@
 #define WAVEFORM_H
 
 #include <cmath>
+#include <limits>
+#include <memory>
+#include <vector>
 const double PI = 3.141592;
 
 // -------------------------------- Wave Forms Like Sinusoidal and DC and Pulse --------------------------------
+// A time where the waveform's slope changes. The transient stepper lands on every breakpoint; a hard one
+// (a PULSE edge) also restarts the integration history with a small step, a soft one (a PWL corner) keeps it.
+struct Breakpoint {
+    double time;
+    bool hard;
+};
+
 class IWaveformStrategy {
 public:
     virtual ~IWaveformStrategy() = default;
     virtual double getValue(double time) const = 0;
+    virtual std::unique_ptr<IWaveformStrategy> clone() const = 0;
+
+    // Times in [from, to] where the waveform or its slope jumps. The transient stepper lands on them
+    // exactly instead of finding the edges by rejecting steps.
+    virtual void getBreakpoints(double /*from*/, double /*to*/, std::vector<Breakpoint>& /*out*/) const {}
+    // Largest step after `time` that still resolves the waveform, infinity when it sets no limit.
+    virtual double getMaxStep(double /*time*/) const { return std::numeric_limits<double>::infinity(); }
 };
 
 class DCWaveform : public IWaveformStrategy {
@@ -17,6 +34,7 @@ private:
 public:
     DCWaveform(double value);
     double getValue(double time) const override;
+    std::unique_ptr<IWaveformStrategy> clone() const override { return std::make_unique<DCWaveform>(*this); }
     void setValue(double v) { dcValue = v; }
 };
 
@@ -26,6 +44,33 @@ private:
 public:
     SinusoidalWaveform(double o, double a, double f);
     double getValue(double time) const override;
+    std::unique_ptr<IWaveformStrategy> clone() const override { return std::make_unique<SinusoidalWaveform>(*this); }
+    double getMaxStep(double time) const override;
+};
+
+// PULSE(V1 V2 TD TR TF PW PER) with SPICE semantics. Missing delay and edges default to 0, a missing
+// width or period to forever.
+class PulseWaveform : public IWaveformStrategy {
+private:
+    double v1, v2, delay, rise, fall, width, period;
+public:
+    PulseWaveform(const std::vector<double>& params);
+    double getValue(double time) const override;
+    std::unique_ptr<IWaveformStrategy> clone() const override { return std::make_unique<PulseWaveform>(*this); }
+    void getBreakpoints(double from, double to, std::vector<Breakpoint>& out) const override;
+};
+
+// PWL(T1 V1 T2 V2 ...), linear between the points and flat outside them. Transient queries move in
+// small steps, so the segment search starts from where the last lookup ended.
+class PwlWaveform : public IWaveformStrategy {
+private:
+    std::vector<double> times, values;
+    mutable size_t cursor;
+public:
+    PwlWaveform(const std::vector<double>& params);
+    double getValue(double time) const override;
+    std::unique_ptr<IWaveformStrategy> clone() const override { return std::make_unique<PwlWaveform>(*this); }
+    void getBreakpoints(double from, double to, std::vector<Breakpoint>& out) const override;
 };
 // -------------------------------- Wave Forms Like Sinusoidal and DC and Pulse --------------------------------
 
@@ -1,5 +1,7 @@
 #include "circuit.h"
+#include "RawFileReader.h"
 #include <limits>
+#include <iomanip>
 
 void printWelcome () {
     std::cout << "Welcome to LTspice OOP Project Sharif University of Technology (Terminal Mode)!" << std::endl;
@@ -25,6 +27,8 @@ void printHelp() {
     std::cout << "    I (DC): add I_bias n_bias GND 1m\n";
     std::cout << "    V (SIN): add Vsig in GND SIN(0 1 1k)  (offset=0, amp=1, freq=1k)\n";
     std::cout << "    I (SIN): add Isig in GND SIN(0 1m 50) (offset=0, amp=1m, freq=50)\n";
+    std::cout << "    V (PULSE): add Vclk in GND PULSE(0 5 1u 10n 10n 5u 10u) (V1 V2 delay rise fall width period)\n";
+    std::cout << "    V (PWL): add Vpwl in GND PWL(0 0 1m 5 2m 0) (time-value pairs)\n";
     std::cout << "    D (Diode): add D1 fwd rev (uses default model)\n";
     std::cout << "    E (VCVS): add Evcvs n_out GND n_in GND 2.5 (V(n_out) = 2.5 * V(n_in))\n";
     std::cout << "    G (VCCS): add Gvccs n_out GND n_in GND 5m (I(n_out) = 5m * V(n_in))\n";
@@ -39,10 +43,21 @@ void printHelp() {
     std::cout << "  fileHere                 - Show the path of the file right now!\n\n";
     std::cout << "ANALYSIS:\n";
     std::cout << "  .DC <SourceName> <StartVal> <EndVal> <Increment> - Perform DC sweep analysis\n";
-    std::cout << "  .TRAN <Tstop> [<Tstep>] [<Tstart>]               - Perform transient analysis\n\n";
+    std::cout << "  .TRAN <Tstop> [<Tstep>] [<Tstart>]               - Perform transient analysis\n";
+    std::cout << "      OUT=<file.csv|file.raw>                      - Stream the results to a file instead of memory\n";
+    std::cout << "  .OPTIONS <name>=<value> ...                      - Set simulator options\n";
+    std::cout << "      SOLVER=SPARSE|DENSE                          - MNA matrix backend (default SPARSE)\n";
+    std::cout << "      METHOD=EULER|TRAP|GEAR                       - Integration method of capacitors and inductors (default TRAP)\n";
+    std::cout << "      TIMESTEP=ADAPTIVE|FIXED                      - Transient step control, Tstep is the maximum step (default ADAPTIVE)\n";
+    std::cout << "      THREADS=<n>                                  - Worker threads of .DC sweeps, 0 for one per core (default 0)\n";
+    std::cout << "      BYPASS=ON|OFF                                - Reuse the stamps of diodes that have settled (default ON)\n";
+    std::cout << "      LUREUSE=<n>                                  - Newton iterations per LU factorization (default 1)\n";
+    std::cout << "      RELTOL, VNTOL, ABSTOL, TRTOL=<value>         - Newton and truncation error tolerances (1e-3, 1e-6, 1e-12, 7)\n\n";
     std::cout << "PRINTING:\n";
     std::cout << "  .print TRAN <Tstop> [<Tstep>] [<Tstart>] <variable1> <variable1> ...               - Print the transient results \n";
-    std::cout << "  .print DC <SourceName> <StartVal> <EndVal> <Increment> <variable1> <variable1> ... - Print the DC sweep results\n\n";
+    std::cout << "  .print DC <SourceName> <StartVal> <EndVal> <Increment> <variable1> <variable1> ... - Print the DC sweep results\n";
+    std::cout << "  .save TRAN|DC <file.raw>                                                          - Save the last results as a binary .raw file\n";
+    std::cout << "  .load <file.raw> [<variable1> <variable2> ...]                                    - List a saved .raw file or print its variables\n\n";
     std::cout << "GENERAL:\n";
     std::cout << "  help            - Show this help message\n";
     std::cout << "  exit            - Quit the program\n";
@@ -50,6 +65,37 @@ void printHelp() {
     std::cout << "----------------------------------------------------------------------------------\n" << std::endl;
 }
 
+// Lists the contents of a saved .raw file, or prints the requested signals as a table
+void printRawFile(const std::string& path, const std::vector<std::string>& signalNames) {
+    RawFileReader reader(path);
+    const std::vector<std::string>& variables = reader.getVariableNames();
+
+    if (signalNames.empty()) {
+        std::cout << reader.getPlotName() << ": " << reader.getPointCount() << " points" << std::endl;
+        for (const auto& name : variables)
+            std::cout << "  " << name << std::endl;
+        return;
+    }
+
+    std::vector<RawFileReader::SignalView> columns = {reader.signal(0)};
+    std::cout << std::left << std::setw(14) << variables[0];
+    for (const auto& name : signalNames) {
+        int index = reader.findVariable(name);
+        if (index == -1)
+            throw std::runtime_error("Signal " + name + " not found in " + path + ".");
+        columns.push_back(reader.signal(index));
+        std::cout << std::setw(14) << name;
+    }
+    std::cout << std::endl;
+
+    for (size_t k = 0; k < reader.getPointCount(); ++k) {
+        std::cout << std::left << std::fixed << std::setprecision(6);
+        for (const auto& column : columns)
+            std::cout << std::setw(14) << column[k];
+        std::cout << std::endl;
+    }
+}
+
 int main() {
     Circuit circuit;
     std::string command;
@@ -140,7 +186,7 @@ int main() {
                         double freq = parseSpiceValue(freq_str);
                         numericParams = {offset, amplitude, freq};
                     }
-                    else
+                    else if (!parseSourceFunction(next_token, ss, numericParams, stringParams))
                         value = parseSpiceValue(next_token);
                 }
                 else if (type_char == 'D') {
@@ -208,16 +254,64 @@ int main() {
                 std::string word;
                 while (ss >> word)
                     params.push_back(word);
+                // OUT=<file> streams the results to a file instead of keeping them for .print
+                std::string outPath;
+                for (auto it = params.begin(); it != params.end(); ++it) {
+                    std::string key = it->substr(0, 4);
+                    std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return std::toupper(c); });
+                    if (key == "OUT=") {
+                        outPath = it->substr(4);
+                        params.erase(it);
+                        break;
+                    }
+                }
                 double tstop = 0.0, tstart = 0.0, tmaxstep = 0.0;
                  if (params.size() < 1)
-                    throw std::runtime_error("Invalid format. Use: .tran <stoptime> [starttime] [maxtimestep]");
+                    throw std::runtime_error("Invalid format. Use: .tran <stoptime> [starttime] [maxtimestep] [OUT=<file>]");
                 if (params.size() >= 1)
                     tstop = parseSpiceValue(params[0]);
                 if (params.size() >= 2)
                     tstart = parseSpiceValue(params[1]);
                 if (params.size() >= 3)
                     tmaxstep = parseSpiceValue(params[2]);
-                circuit.performTransientAnalysis( tstop, tstart, tmaxstep);
+                if (outPath.empty())
+                    circuit.performTransientAnalysis( tstop, tstart, tmaxstep);
+                else {
+                    std::unique_ptr<ITransientSink> sink = createTransientSink(outPath);
+                    circuit.performTransientAnalysis(tstop, tstart, tmaxstep, sink.get());
+                    std::cout << "Results written to " << outPath << std::endl;
+                }
+            }
+
+            else if (cmdType == ".OPTIONS") {
+                std::string option;
+                bool anyOption = false;
+                while (ss >> option) {
+                    size_t eq = option.find('=');
+                    if (eq == std::string::npos || eq == 0 || eq == option.size() - 1)
+                        throw std::runtime_error("Invalid syntax - correct form:\n.OPTIONS <name>=<value> ...");
+                    circuit.setOption(option.substr(0, eq), option.substr(eq + 1));
+                    anyOption = true;
+                }
+                if (!anyOption)
+                    throw std::runtime_error("Invalid syntax - correct form:\n.OPTIONS <name>=<value> ...");
+            }
+
+            else if (cmdType == ".load") {
+                std::string path, word;
+                std::vector<std::string> signalNames;
+                if (!(ss >> path))
+                    throw std::runtime_error("Invalid syntax - correct form:\n.load <file.raw> [<variable1> <variable2> ...]");
+                while (ss >> word)
+                    signalNames.push_back(word);
+                printRawFile(path, signalNames);
+            }
+
+            else if (cmdType == ".save") {
+                std::string analysisType, path;
+                if (!(ss >> analysisType >> path))
+                    throw std::runtime_error("Invalid syntax - correct form:\n.save TRAN|DC <file.raw>");
+                circuit.saveRawFile(path, analysisType);
             }
 
             else if (cmdType == ".print") {
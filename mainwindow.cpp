@@ -1,6 +1,10 @@
 #include "mainwindow.h"
 
 #include "NetworkDialog.h"
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QInputDialog>
+#include <memory>
 
 MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent), ui(new Ui::MainWindow) {
     ui->setupUi(this);
@@ -11,6 +15,10 @@ MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent), ui(new Ui::MainWi
 }
 
 MainWindow::~MainWindow() {
+    if (simulationThread) {
+        simulationWorker->cancel();
+        finishSimulation();
+    }
     delete ui;
 }
 
@@ -101,6 +109,7 @@ void MainWindow::starterWindow() {
     connect(newSchematicAction, &QAction::triggered, this, &MainWindow::hNewSchematic);
     connect(quitAction, &QAction::triggered, this, &QApplication::quit);
     connect(settingsAction, &QAction::triggered, this, &MainWindow::hShowSettings);
+    connect(openWaveformAction, &QAction::triggered, this, &MainWindow::openWaveformFile);
 
     shortcutRunner();
     implementMenuBar();
@@ -124,6 +133,7 @@ void MainWindow::initializeActions() {
     labelAction = new QAction(QIcon(":/icon/icons/text.png"), "Text (T)", this);
     deleteModeAction = new QAction(QIcon(":/icon/icons/deleteMode.png"), "Delete Mode (Backspace or Del)", this);
     quitAction = new QAction("Exit", this);
+    openWaveformAction = new QAction("Open Waveform (.raw)...", this);
     //////////////////////////////////////////////////////////////////////////////////////////////////////
     networkAction = new QAction(QIcon(":/icon/icons/network.png"), "Network (N)", this); // New network action
     //////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -133,6 +143,7 @@ void MainWindow::implementMenuBar() {
     QMenu* file = menuBar()->addMenu(tr("&File"));
     file->addAction(newSchematicAction);
     file->addAction(openAction);
+    file->addAction(openWaveformAction);
     file->addSeparator();
     file->addAction(quitAction);
 
@@ -219,40 +230,144 @@ void MainWindow::shortcutRunner() {
 
 
 void MainWindow::openTransientDialog() {
+    if (simulationThread) {
+        QMessageBox::information(this, "Simulation Running", "Wait for the running simulation to finish or cancel it first.");
+        return;
+    }
+
     TransientDialog dialog(this);
     if (dialog.exec() == QDialog::Accepted) {
         double startTime = dialog.getStartTime();
         double stopTime = dialog.getStopTime();
         double stepTime = dialog.getStepTime();
         QString parameter = dialog.getParameter();
+        bool livePlot = dialog.isLivePlot();
 
         if (stepTime <= 0) {
             QMessageBox::warning(this, "Input Error", "Step time must be greater than zero.");
             return;
         }
 
-        // Call your existing transient analysis function to run the simulation and store results
-        circuit.runTransientAnalysis(stopTime, startTime, stepTime);
+        // The analysis runs on a copy of the circuit, so the schematic stays editable meanwhile
+        simulationWorker = new SimulationWorker(circuit.snapshot(), startTime, stopTime, stepTime);
+        simulationThread = new QThread(this);
+        simulationWorker->moveToThread(simulationThread);
 
-        // Get the specific data to plot using the new function
-        std::pair<std::string, std::vector<double>> results = circuit.getTransientResults(parameter.toStdString());
-
-        // Check if there's any data to plot
-        if (!results.second.empty()) {
-            // Create and show the new plot window
-            PlotWindow *plotWindow = new PlotWindow(this);
-            std::vector<double> timePoints;
-            for (double t = startTime; t <= stopTime; t += stepTime) {
-                timePoints.push_back(t);
-            }
-            plotWindow->plotData(timePoints, results.second, QString::fromStdString(results.first));
+        // Accepted points stream into the plot while the analysis runs
+        QPointer<PlotWindow> plotWindow;
+        if (livePlot) {
+            plotWindow = new PlotWindow(this);
+            plotWindow->beginLivePlot(startTime, stopTime, parameter);
             plotWindow->show();
-        } else {
-            QMessageBox::warning(this, "Analysis Failed", "Could not generate plot data. Please check your circuit and parameters.");
+            simulationWorker->setLiveProbe(parameter.toStdString());
+            connect(simulationWorker, &SimulationWorker::pointsReady, plotWindow, &PlotWindow::appendLivePoints);
         }
+
+        // Closing the dialog cancels the run and deletes it, hence the guarded pointer
+        QPointer<QProgressDialog> progressDialog = new QProgressDialog("Running transient analysis...", "Cancel", 0, 1000, this);
+        progressDialog->setWindowModality(Qt::NonModal);
+        progressDialog->setAutoReset(false);
+        progressDialog->setAutoClose(false);
+        progressDialog->setAttribute(Qt::WA_DeleteOnClose);
+        progressDialog->setMinimumDuration(500);
+
+        // cancel() only sets a flag, so it is called directly rather than queued behind the running analysis
+        SimulationWorker *worker = simulationWorker;
+        connect(progressDialog, &QProgressDialog::canceled, this, [worker]() { worker->cancel(); });
+        connect(simulationThread, &QThread::started, simulationWorker, &SimulationWorker::run);
+        connect(simulationWorker, &SimulationWorker::progress, progressDialog,
+                [progressDialog, startTime, stopTime](double time, qulonglong steps, double stepsPerSecond) {
+                    double span = stopTime - startTime;
+                    progressDialog->setValue(span > 0 ? static_cast<int>(1000 * (time - startTime) / span) : 0);
+                    progressDialog->setLabelText(QString("t = %1 s    %2 steps    %3 steps/s")
+                                                     .arg(time).arg(steps).arg(stepsPerSecond, 0, 'f', 0));
+                });
+        connect(simulationWorker, &SimulationWorker::finished, this, [this, progressDialog, plotWindow, livePlot, parameter](bool) {
+            if (progressDialog)
+                progressDialog->close();
+            // A cancelled run still shows the part that was simulated
+            if (!livePlot)
+                showTransientPlot(simulationWorker->getCircuit(), parameter);
+            else if (plotWindow) {
+                std::pair<std::string, std::vector<double>> data = simulationWorker->getCircuit().getTransientResults(parameter.toStdString());
+                if (data.second.empty())
+                    QMessageBox::warning(this, "Analysis Failed", "Could not generate plot data. Please check your circuit and parameters.");
+                plotWindow->endLivePlot(QString::fromStdString(data.first));
+            }
+            finishSimulation();
+        });
+        connect(simulationWorker, &SimulationWorker::failed, this, [this, progressDialog](const QString& message) {
+            if (progressDialog)
+                progressDialog->close();
+            finishSimulation();
+            QMessageBox::warning(this, "Analysis Failed", message);
+        });
+
+        simulationThread->start();
+    }
+}
+
+void MainWindow::showTransientPlot(Circuit& results, const QString& parameter) {
+    // Get the specific data to plot using the new function
+    std::pair<std::string, std::vector<double>> data = results.getTransientResults(parameter.toStdString());
+
+    // Check if there's any data to plot
+    if (!data.second.empty()) {
+        // Create and show the new plot window
+        PlotWindow *plotWindow = new PlotWindow(this);
+        plotWindow->plotData(results.getTransientTimePoints(), data.second, QString::fromStdString(data.first));
+        plotWindow->show();
+    } else {
+        QMessageBox::warning(this, "Analysis Failed", "Could not generate plot data. Please check your circuit and parameters.");
     }
 }
 
+// Plots one signal of a .raw file written by .save or another simulator. The file stays mapped by the
+// plot window, so opening it costs the same for any size.
+void MainWindow::openWaveformFile() {
+    QString path = QFileDialog::getOpenFileName(this, "Open Waveform", QString(), "SPICE raw files (*.raw);;All files (*)");
+    if (path.isEmpty())
+        return;
+
+    std::shared_ptr<RawFileReader> reader;
+    try {
+        reader = std::make_shared<RawFileReader>(path.toStdString());
+    } catch (const std::exception& e) {
+        QMessageBox::warning(this, "Open Waveform", QString::fromStdString(e.what()));
+        return;
+    }
+    const std::vector<std::string>& names = reader->getVariableNames();
+    if (names.size() < 2 || reader->getPointCount() == 0) {
+        QMessageBox::warning(this, "Open Waveform", "The file holds no signals to plot.");
+        return;
+    }
+
+    // Index 0 is the sweep axis, the rest are the signals
+    QStringList signalNames;
+    for (size_t i = 1; i < names.size(); ++i)
+        signalNames << QString::fromStdString(names[i]);
+    bool ok = true;
+    QString chosen = signalNames.size() == 1 ? signalNames.front()
+                   : QInputDialog::getItem(this, "Open Waveform", "Signal:", signalNames, 0, false, &ok);
+    if (!ok)
+        return;
+
+    PlotWindow *plotWindow = new PlotWindow(this);
+    plotWindow->plotData(reader, static_cast<int>(signalNames.indexOf(chosen)) + 1, chosen);
+    plotWindow->setWindowTitle(QFileInfo(path).fileName());
+    plotWindow->show();
+}
+
+// The worker has returned from run() when this is called, so the thread only has its event loop left.
+void MainWindow::finishSimulation() {
+    simulationThread->quit();
+    simulationThread->wait();
+    delete simulationWorker;
+    delete simulationThread;
+    simulationWorker = nullptr;
+    simulationThread = nullptr;
+}
+
 void MainWindow::openNetworkDialog() {
     if (tcpServer || tcpClient) {
         QMessageBox::warning(this, "Network Error", "A network connection is already active. Please restart the application to change settings.");
@@ -21,6 +21,10 @@
 #include "Circuit.h"
 #include "TcpClient.h"
 #include "TcpServer.h"
+#include "SimulationWorker.h"
+#include <QThread>
+#include <QProgressDialog>
+#include <QPointer>
 
 
 namespace Ui {
@@ -42,12 +46,19 @@ private:
 
     TcpServer *tcpServer = nullptr;
     TcpClient *tcpClient = nullptr;
+
+    // Transient analysis running in the background, null when idle
+    QThread *simulationThread = nullptr;
+    SimulationWorker *simulationWorker = nullptr;
+    void showTransientPlot(Circuit& results, const QString& parameter);
+    void finishSimulation();
     //////////////////////////////////////////////////////////////////////////////////
 
     // Some items in menu bar to disable and enabling them
     QAction* settingsAction;
     QAction* newSchematicAction;
     QAction* openAction;
+    QAction* openWaveformAction;
     QAction* configureAnalysisAction;
     QAction* runAction;
     QAction* wireAction;
@@ -67,6 +78,7 @@ private:
         ///////////////////////////////////////////////////////////////////
         void openTransientDialog();
         void openNetworkDialog();
+        void openWaveformFile();
         void updateVoltageFromNetwork(double voltage);
         void updateNetworkStatus(const QString& msg);
         //////////////////////////////////////////////////////////////////